@@ -0,0 +1,372 @@
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <system_error>
+#include <sys/stat.h>
+#include "SymbolTableEntry.h"
+#include "MappedFile.h"
+#include "ListReader.h"
+using namespace std;
+
+// Chunks smaller than this are not worth a thread of their own.
+const size_t CSV_MIN_CHUNK_SIZE = 1 << 20;
+
+// CSV_TABLE::readColumn() results
+#define CSV_OK                 0
+#define CSV_CANNOT_OPEN        -1
+#define CSV_OUT_OF_RANGE       1   // a number does not fit its type
+#define CSV_MISSING_VALUE      2   // an INT, FLOAT or BOOL column has an empty field
+#define CSV_NO_SUCH_COLUMN     3
+#define CSV_STRING_TOO_LONG    4   // a STR field does not fit a TYPE
+
+// One field of a CSV record, as a view into the mapped file.
+typedef struct {
+  const char* text;
+  size_t length;
+} CSV_FIELD;
+
+// The records between begin and end, split into fields by one
+// worker thread.
+typedef struct {
+  const char* begin;
+  const char* end;
+  size_t firstRecord;                 // index of this chunk's first record
+  vector< vector<CSV_FIELD> > fields; // fields[column][record]
+  vector<int> typeCodes;              // OR of the type codes seen per column
+  int status;                         // CSV_OK, or why a field did not convert
+} CSV_CHUNK;
+
+// Return a pointer just past the end of the CSV record starting at
+// p, storing its fields in fields. Quoted fields may contain commas
+// and doubled quotes, but not line breaks.
+inline const char* splitCsvRecord(const char* p, const char* end,
+                                  vector<CSV_FIELD>& fields)
+{
+  fields.clear();
+  const char* nl = (const char*) memchr(p, '\n', end - p);
+  const char* recordEnd = (nl == NULL) ? end : nl;
+  const char* next = (nl == NULL) ? end : nl + 1;
+  if ((recordEnd > p) && (recordEnd[-1] == '\r'))
+    recordEnd--;
+
+  while (true)
+  {
+    while ((p < recordEnd) && ((*p == ' ') || (*p == '\t')))
+      p++;
+    CSV_FIELD field;
+    field.text = p;
+    if ((p < recordEnd) && (*p == '"'))
+    {
+      // keep the quotes so the field is typed as a STR
+      p++;
+      while (p < recordEnd)
+      {
+        if (*p == '"')
+        {
+          if ((p + 1 < recordEnd) && (p[1] == '"'))
+            p++;
+          else
+            break;
+        }
+        p++;
+      }
+      if (p < recordEnd)
+        p++;
+      field.length = p - field.text;
+      p = (p < recordEnd) ? (const char*) memchr(p, ',', recordEnd - p) : NULL;
+    }
+    else
+    {
+      const char* comma = (p < recordEnd) ? (const char*) memchr(p, ',', recordEnd - p) : NULL;
+      const char* fieldEnd = (comma == NULL) ? recordEnd : comma;
+      while ((fieldEnd > p) && ((fieldEnd[-1] == ' ') || (fieldEnd[-1] == '\t')))
+        fieldEnd--;
+      field.length = fieldEnd - field.text;
+      p = comma;
+    }
+    fields.push_back(field);
+    if (p == NULL)
+      break;
+    p++;
+  }
+  return(next);
+}
+
+// Build into element a list element of type theType from field. A
+// quoted field loses its quotes and has its doubled quotes collapsed.
+// Returns what makeTypedElement() does: 0 if successful, 1 if a
+// number is out of range, or 2 if a STR is too long.
+inline int makeCsvElement(const CSV_FIELD& field, const int theType, TYPE& element)
+{
+  if ((field.length < 2) || (field.text[0] != '"'))
+    return(makeTypedElement(field.text, field.length, theType, element));
+
+  memset(&element, 0, sizeof(element));
+  element.type = STR;
+  size_t n = 0;
+  for (size_t i = 1; i < field.length - 1; i++)
+  {
+    if (!fitsStringValue(n + 1))
+      return(2);
+    element.stringValue[n++] = field.text[i];
+    if ((field.text[i] == '"') && (field.text[i+1] == '"'))
+      i++;
+  }
+  element.stringValue[n] = '\0';
+  return(0);
+}
+
+// Split the records of chunk into fields, one list of fields per
+// column, and note which type codes appear in each column.
+inline void splitCsvChunk(CSV_CHUNK* chunk, const size_t numColumns)
+{
+  chunk->fields.assign(numColumns, vector<CSV_FIELD>());
+  chunk->typeCodes.assign(numColumns, 0);
+  vector<CSV_FIELD> record;
+  const CSV_FIELD emptyField = {"", 0};
+  const char* p = chunk->begin;
+  while (p < chunk->end)
+  {
+    p = splitCsvRecord(p, chunk->end, record);
+    // skip blank lines
+    if ((record.size() == 1) && (record[0].length == 0))
+      continue;
+    for (size_t col = 0; col < numColumns; col++)
+    {
+      const CSV_FIELD& field = (col < record.size()) ? record[col] : emptyField;
+      chunk->fields[col].push_back(field);
+      // empty fields don't constrain the column type
+      if (field.length > 0)
+        chunk->typeCodes[col] |= classifyText(field.text, field.length);
+    }
+  }
+}
+
+// Convert the fields of chunk into the preallocated columns, each
+// according to its inferred type, noting in chunk->status a field
+// that cannot be: a number out of range, a string too long, or an
+// empty field in a column that is not STR (there is no value to
+// stand for a missing one, and 0 or FALSE would pass for data).
+inline void convertCsvChunk(CSV_CHUNK* chunk,
+                            vector< vector<TYPE> >* columns,
+                            const vector<int>* columnTypes)
+{
+  chunk->status = CSV_OK;
+  for (size_t col = 0; col < columns->size(); col++)
+  {
+    const vector<CSV_FIELD>& fields = chunk->fields[col];
+    const int theType = (*columnTypes)[col];
+    TYPE* out = &(*columns)[col][chunk->firstRecord];
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+      int status;
+      if ((fields[i].length == 0) && (theType != STR))
+        chunk->status = CSV_MISSING_VALUE;
+      else if ((status = makeCsvElement(fields[i], theType, out[i])) != 0)
+        chunk->status = (status == 1) ? CSV_OUT_OF_RANGE : CSV_STRING_TOO_LONG;
+    }
+  }
+}
+
+// Run f(chunk, args...) on a new thread added to workers or, if no
+// thread can be started, on this one.
+template <class F, class... ARGS>
+inline void runCsvWorker(vector<thread>& workers, F f, CSV_CHUNK* chunk, ARGS... args)
+{
+  try
+  {
+    workers.push_back(thread(f, chunk, args...));
+  }
+  catch (const system_error&)
+  {
+    f(chunk, args...);
+  }
+}
+
+// The columns of a CSV file, each a typed list. The first record
+// of the file names the columns. A column is handed to the script
+// as it is, not copied, so the table no longer has it afterwards.
+class CSV_TABLE
+{
+private:
+  string fileName;
+  struct timespec modTime;
+  ino_t inode;
+  off_t fileSize;
+  vector<string> names;
+  vector< vector<TYPE> > columns;
+  vector<int> columnTypes;
+  vector<bool> taken;       // handed out by readColumn()
+
+  // Reduce the type codes seen in a column to the one type the
+  // whole column is stored as.
+  static int columnTypeOf(const int typeCodes)
+  {
+    if ((typeCodes == INT) || (typeCodes == BOOL) || (typeCodes == FLOAT))
+      return(typeCodes);
+    if (typeCodes == INT_OR_FLOAT)
+      return(FLOAT);
+    return(STR);
+  }
+
+public:
+  //Constructor
+  CSV_TABLE( ) : inode(0), fileSize(-1) { modTime.tv_sec = modTime.tv_nsec = 0; }
+
+  // Read the CSV file named theFileName, parsing it on as many
+  // threads as it has chunks. Nothing is re-read if it is the same,
+  // unchanged file (same inode, size and modification time to the
+  // nanosecond) as last time.
+  // Return CSV_OK, CSV_CANNOT_OPEN, CSV_OUT_OF_RANGE,
+  // CSV_MISSING_VALUE or CSV_STRING_TOO_LONG.
+  int read(const char* theFileName)
+  {
+    struct stat st;
+    if (stat(theFileName, &st) != 0)
+      return(CSV_CANNOT_OPEN);
+    if ((fileName == theFileName) && (inode == st.st_ino)
+    && (modTime.tv_sec == st.st_mtim.tv_sec)
+    && (modTime.tv_nsec == st.st_mtim.tv_nsec)
+    && (fileSize == st.st_size))
+      return(CSV_OK);
+
+    MAPPED_FILE file;
+    if (!file.open(theFileName))
+      return(CSV_CANNOT_OPEN);
+    fileName = "";
+    names.clear();
+    columns.clear();
+    columnTypes.clear();
+    taken.clear();
+
+    const char* p = file.getData();
+    const char* end = p + file.getSize();
+    vector<CSV_FIELD> header;
+    if (p < end)
+      p = splitCsvRecord(p, end, header);
+    for (size_t col = 0; col < header.size(); col++)
+    {
+      CSV_FIELD field = header[col];
+      if ((field.length >= 2) && (field.text[0] == '"'))
+      {
+        field.text++;
+        field.length -= 2;
+      }
+      names.push_back(string(field.text, field.length));
+    }
+    size_t numColumns = names.size();
+
+    // cut the body into chunks that end on record boundaries
+    size_t numChunks = (end - p) / CSV_MIN_CHUNK_SIZE;
+    size_t maxThreads = thread::hardware_concurrency();
+    if (numChunks > maxThreads)
+      numChunks = maxThreads;
+    if (numChunks < 1)
+      numChunks = 1;
+    vector<CSV_CHUNK> chunks(numChunks);
+    const char* chunkBegin = p;
+    for (size_t i = 0; i < numChunks; i++)
+    {
+      const char* chunkEnd = end;
+      if (i < numChunks - 1)
+      {
+        chunkEnd = p + (end - p) / numChunks * (i + 1);
+        if (chunkEnd < chunkBegin)
+          chunkEnd = chunkBegin;
+        const char* nl = (const char*) memchr(chunkEnd, '\n', end - chunkEnd);
+        chunkEnd = (nl == NULL) ? end : nl + 1;
+      }
+      chunks[i].begin = chunkBegin;
+      chunks[i].end = chunkEnd;
+      chunkBegin = chunkEnd;
+    }
+
+    vector<thread> workers;
+    for (size_t i = 1; i < numChunks; i++)
+      runCsvWorker(workers, splitCsvChunk, &chunks[i], numColumns);
+    splitCsvChunk(&chunks[0], numColumns);
+    for (size_t i = 0; i < workers.size(); i++)
+      workers[i].join();
+    workers.clear();
+
+    size_t numRecords = 0;
+    vector<int> typeCodes(numColumns, 0);
+    for (size_t i = 0; i < numChunks; i++)
+    {
+      chunks[i].firstRecord = numRecords;
+      if (numColumns > 0)
+        numRecords += chunks[i].fields[0].size();
+      for (size_t col = 0; col < numColumns; col++)
+        typeCodes[col] |= chunks[i].typeCodes[col];
+    }
+    for (size_t col = 0; col < numColumns; col++)
+      columnTypes.push_back(columnTypeOf(typeCodes[col]));
+    columns.assign(numColumns, vector<TYPE>(numRecords));
+
+    for (size_t i = 1; i < numChunks; i++)
+      runCsvWorker(workers, convertCsvChunk, &chunks[i], &columns, &columnTypes);
+    convertCsvChunk(&chunks[0], &columns, &columnTypes);
+    for (size_t i = 0; i < workers.size(); i++)
+      workers[i].join();
+    for (size_t i = 0; i < numChunks; i++)
+      if (chunks[i].status != CSV_OK)
+        return(chunks[i].status);
+
+    taken.assign(numColumns, false);
+    fileName = theFileName;
+    inode = st.st_ino;
+    modTime = st.st_mtim;
+    fileSize = st.st_size;
+    return(CSV_OK);
+  }
+
+  // Read the column of the CSV file named theFileName that name
+  // picks or, if name is NULL, the index'th (from 0), into *list, a
+  // new list the caller owns. The column is moved there from the
+  // table, so one taken before is read from the file again.
+  // Return CSV_OK, CSV_CANNOT_OPEN, CSV_OUT_OF_RANGE,
+  // CSV_MISSING_VALUE, CSV_STRING_TOO_LONG or CSV_NO_SUCH_COLUMN.
+  int readColumn(const char* theFileName, const string* name, const int index,
+                 vector<TYPE>** list)
+  {
+    for (int attempt = 0; attempt < 2; attempt++)
+    {
+      int status = read(theFileName);
+      if (status != CSV_OK)
+        return(status);
+      int col = (name != NULL) ? findColumn(*name) : index;
+      if ((col < 0) || (col >= getNumColumns()))
+        return(CSV_NO_SUCH_COLUMN);
+      if (!taken[col])
+      {
+        *list = new vector<TYPE>;
+        (*list)->swap(columns[col]);
+        taken[col] = true;
+        return(CSV_OK);
+      }
+      fileName = "";
+    }
+    return(CSV_CANNOT_OPEN);
+  }
+
+  // Return the index of the column named theName, or -1 if there
+  // is no such column.
+  int findColumn(const string theName) const
+  {
+    for (size_t col = 0; col < names.size(); col++)
+      if (names[col] == theName)
+        return(col);
+    return(-1);
+  }
+
+  // Accessors
+  int getNumColumns() const { return columns.size(); }
+  int getColumnType(const int col) const { return columnTypes[col]; }
+
+};
+
+#endif  // CSV_READER_H
@@ -0,0 +1,380 @@
+#ifndef FAST_SCANNER_H
+#define FAST_SCANNER_H
+
+/*
+  A hand-written scanner for the tokens in hol.l, used instead of
+  the flex one unless MINIR_SCANNER=flex (see INTERPRETER::scannerKind).
+  It returns the same tokens, values and line numbers, but skips
+  runs of white space, comment text, identifier characters and
+  digits 16 (SSE2) or 32 (AVX2) bytes at a time instead of one byte
+  per DFA transition, and counts newlines with vector compares.
+
+  It uses the T_ token codes, YYSTYPE and printTokenInfo() from
+  hol.y, so hol.y includes it after them. The SCANNER_ levels are
+  in Interpreter.h.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FAST_SCANNER_SIMD
+#endif
+#include "Keywords.h"
+#include "Literals.h"
+using namespace std;
+
+// character classes
+#define CHAR_SPACE      1   // [ \t\v\r\n]
+#define CHAR_IDENT      2   // [a-zA-Z0-9_]
+#define CHAR_DIGIT      4   // [0-9]
+
+class FAST_SCANNER
+{
+private:
+  char* next;           // where scanning resumes
+  char* end;            // the end of the script
+  int& lineNum;
+  int level;            // SCANNER_SSE2 or SCANNER_AVX2
+  unsigned char classes[256];
+
+  // Return the first byte from p on that is not in charClass.
+  char* skipScalar(char* p, const int charClass) const
+  {
+    while ((p < end) && (classes[(unsigned char) *p] & charClass))
+      p++;
+    return(p);
+  }
+
+  // Return the first newline from p on, or end.
+  char* findNewlineScalar(char* p) const
+  {
+    char* newline = (char*) memchr(p, '\n', end - p);
+    return((newline != NULL) ? newline : end);
+  }
+
+  // Count the newlines from start up to p.
+  void countLines(const char* start, const char* p)
+  {
+    for (; start < p; start++)
+      lineNum += (*start == '\n');
+  }
+
+#ifdef FAST_SCANNER_SIMD
+  // The vector loops below stop 16 or 32 bytes short of end, and
+  // the scalar ones finish, so no load reads past the script.
+
+  // Masks of the bytes in x that are white space (including
+  // newlines), identifier characters, digits and newlines.
+  static unsigned spaceMask(const __m128i x)
+  {
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8('\t'));   // \t..\r -> 0..4
+    __m128i inRange = _mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(4)), d);
+    __m128i formFeed = _mm_cmpeq_epi8(x, _mm_set1_epi8('\f'));
+    __m128i blank = _mm_cmpeq_epi8(x, _mm_set1_epi8(' '));
+    return(_mm_movemask_epi8(_mm_or_si128(blank, _mm_andnot_si128(formFeed, inRange))));
+  }
+
+  static unsigned digitMask(const __m128i x)
+  {
+    __m128i d = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+    return(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(d, _mm_set1_epi8(9)), d)));
+  }
+
+  static unsigned identMask(const __m128i x)
+  {
+    __m128i lower = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i letter = _mm_cmpeq_epi8(_mm_min_epu8(lower, _mm_set1_epi8(25)), lower);
+    __m128i underscore = _mm_cmpeq_epi8(x, _mm_set1_epi8('_'));
+    return(_mm_movemask_epi8(_mm_or_si128(letter, underscore)) | digitMask(x));
+  }
+
+  static unsigned newlineMask(const __m128i x)
+  {
+    return(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8('\n'))));
+  }
+
+  char* skipSpaceSse2(char* p)
+  {
+    for (; p + 16 <= end; p += 16)
+    {
+      __m128i x = _mm_loadu_si128((const __m128i*) p);
+      unsigned other = ~spaceMask(x) & 0xFFFF;
+      unsigned newlines = newlineMask(x);
+      if (other != 0)
+      {
+        int n = __builtin_ctz(other);
+        lineNum += __builtin_popcount(newlines & ((1u << n) - 1));
+        return(p + n);
+      }
+      lineNum += __builtin_popcount(newlines);
+    }
+    char* start = p;
+    p = skipScalar(p, CHAR_SPACE);
+    countLines(start, p);
+    return(p);
+  }
+
+  char* skipSse2(char* p, const int charClass) const
+  {
+    for (; p + 16 <= end; p += 16)
+    {
+      __m128i x = _mm_loadu_si128((const __m128i*) p);
+      unsigned other = ~((charClass == CHAR_DIGIT) ? digitMask(x) : identMask(x)) & 0xFFFF;
+      if (other != 0)
+        return(p + __builtin_ctz(other));
+    }
+    return(skipScalar(p, charClass));
+  }
+
+  char* findNewlineSse2(char* p) const
+  {
+    for (; p + 16 <= end; p += 16)
+    {
+      unsigned newlines = newlineMask(_mm_loadu_si128((const __m128i*) p));
+      if (newlines != 0)
+        return(p + __builtin_ctz(newlines));
+    }
+    return(findNewlineScalar(p));
+  }
+
+#pragma GCC push_options
+#pragma GCC target("avx2")
+  static unsigned spaceMask256(const __m256i x)
+  {
+    __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8('\t'));
+    __m256i inRange = _mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(4)), d);
+    __m256i formFeed = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('\f'));
+    __m256i blank = _mm256_cmpeq_epi8(x, _mm256_set1_epi8(' '));
+    return(_mm256_movemask_epi8(_mm256_or_si256(blank, _mm256_andnot_si256(formFeed, inRange))));
+  }
+
+  static unsigned digitMask256(const __m256i x)
+  {
+    __m256i d = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+    return(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(d, _mm256_set1_epi8(9)), d)));
+  }
+
+  static unsigned identMask256(const __m256i x)
+  {
+    __m256i lower = _mm256_sub_epi8(_mm256_or_si256(x, _mm256_set1_epi8(0x20)),
+                                    _mm256_set1_epi8('a'));
+    __m256i letter = _mm256_cmpeq_epi8(_mm256_min_epu8(lower, _mm256_set1_epi8(25)), lower);
+    __m256i underscore = _mm256_cmpeq_epi8(x, _mm256_set1_epi8('_'));
+    return(_mm256_movemask_epi8(_mm256_or_si256(letter, underscore)) | digitMask256(x));
+  }
+
+  static unsigned newlineMask256(const __m256i x)
+  {
+    return(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8('\n'))));
+  }
+
+  char* skipSpaceAvx2(char* p)
+  {
+    for (; p + 32 <= end; p += 32)
+    {
+      __m256i x = _mm256_loadu_si256((const __m256i*) p);
+      unsigned other = ~spaceMask256(x);
+      unsigned newlines = newlineMask256(x);
+      if (other != 0)
+      {
+        int n = __builtin_ctz(other);
+        lineNum += __builtin_popcount(newlines & ((1u << n) - 1));
+        return(p + n);
+      }
+      lineNum += __builtin_popcount(newlines);
+    }
+    return(skipSpaceSse2(p));
+  }
+
+  char* skipAvx2(char* p, const int charClass) const
+  {
+    for (; p + 32 <= end; p += 32)
+    {
+      __m256i x = _mm256_loadu_si256((const __m256i*) p);
+      unsigned other = ~((charClass == CHAR_DIGIT) ? digitMask256(x) : identMask256(x));
+      if (other != 0)
+        return(p + __builtin_ctz(other));
+    }
+    return(skipSse2(p, charClass));
+  }
+
+  char* findNewlineAvx2(char* p) const
+  {
+    for (; p + 32 <= end; p += 32)
+    {
+      unsigned newlines = newlineMask256(_mm256_loadu_si256((const __m256i*) p));
+      if (newlines != 0)
+        return(p + __builtin_ctz(newlines));
+    }
+    return(findNewlineSse2(p));
+  }
+#pragma GCC pop_options
+
+  char* skipSpace(char* p)
+  {
+    return((level == SCANNER_AVX2) ? skipSpaceAvx2(p) : skipSpaceSse2(p));
+  }
+
+  char* skip(char* p, const int charClass) const
+  {
+    return((level == SCANNER_AVX2) ? skipAvx2(p, charClass) : skipSse2(p, charClass));
+  }
+
+  char* findNewline(char* p) const
+  {
+    return((level == SCANNER_AVX2) ? findNewlineAvx2(p) : findNewlineSse2(p));
+  }
+#else
+  char* skipSpace(char* p)
+  {
+    char* start = p;
+    p = skipScalar(p, CHAR_SPACE);
+    countLines(start, p);
+    return(p);
+  }
+
+  char* skip(char* p, const int charClass) const { return(skipScalar(p, charClass)); }
+
+  char* findNewline(char* p) const { return(findNewlineScalar(p)); }
+#endif  // FAST_SCANNER_SIMD
+
+  bool isDigit(const char c) const { return(classes[(unsigned char) c] & CHAR_DIGIT); }
+
+  // Finish a token of length bytes at start: pass it to
+  // printTokenInfo() as flex would, and move past it.
+  int finish(char* start, const int length, const char* name, const int token)
+  {
+    next = start + length;
+    char held = *next;    // as flex does, end the text in place
+    *next = '\0';
+    printTokenInfo(name, start);
+    *next = held;
+    return(token);
+  }
+
+public:
+  //Constructor
+  // buffer holds size bytes of script, followed by two NULs as for
+  // yy_scan_buffer(); it is written to, but left as it was.
+  FAST_SCANNER(char* buffer, const size_t size, int& theLineNum, const int theLevel)
+    : next(buffer), end(buffer + size), lineNum(theLineNum), level(theLevel)
+  {
+    memset(classes, 0, sizeof(classes));
+    for (int c = 0; c < 256; c++)
+    {
+      if (strchr(" \t\v\r\n", c) && (c != 0))
+        classes[c] |= CHAR_SPACE;
+      if (isalnum(c) || (c == '_'))
+        classes[c] |= CHAR_IDENT;
+      if (isdigit(c))
+        classes[c] |= CHAR_DIGIT;
+    }
+#ifdef FAST_SCANNER_SIMD
+    if ((level == SCANNER_FAST) || (level == SCANNER_AVX2))
+      level = __builtin_cpu_supports("avx2") ? SCANNER_AVX2 : SCANNER_SSE2;
+#endif
+  }
+
+  // Scan the next token into value and return its code, or 0 at
+  // the end of the script, as the flex scanner does.
+  int scan(YYSTYPE* value)
+  {
+    char* p = next;
+    for (;;)
+    {
+      p = skipSpace(p);
+      if ((p < end) && (*p == '#'))
+        p = findNewline(p + 1);
+      else
+        break;
+    }
+    if (p >= end)
+    {
+      next = end;
+      return(0);
+    }
+
+    char c = *p;
+    if (isalpha((unsigned char) c) || (c == '_'))
+    {
+      int length = skip(p + 1, CHAR_IDENT) - p;
+      const KEYWORD* keyword = findKeyword(p, length);
+      if (keyword != NULL)
+      {
+        value->boolValue = (keyword->token == T_TRUE);
+        return(finish(p, length, keyword->name, keyword->token));
+      }
+      value->text.start = p;
+      value->text.length = length;
+      return(finish(p, length, "IDENT", T_IDENT));
+    }
+
+    // INTCONST and FLOATCONST take a sign, so "-1" is one token;
+    // the bytes after end are NULs, so p[1] and p[2] can be read
+    char* digits = ((c == '+') || (c == '-')) ? p + 1 : p;
+    if (isDigit(*digits) || ((*digits == '.') && isDigit(digits[1])))
+    {
+      char* q = skip(digits, CHAR_DIGIT);
+      bool isFloat = (*q == '.') && isDigit(q[1]);
+      if (isFloat)
+        q = skip(q + 1, CHAR_DIGIT);
+      int token = isFloat ? finish(p, q - p, "FLOATCONST", T_FLOATCONST)
+                          : finish(p, q - p, "INTCONST", T_INTCONST);
+      if (!(isFloat ? parseFloatLiteral(p, q - p, value->floatValue)
+                    : parseIntLiteral(p, q - p, value->intValue)))
+        throw MINIR_ERROR(lineNum, NUMBER_RANGE_MESSAGE);
+      return(token);
+    }
+
+    switch (c)
+    {
+      case '"':
+      {
+        // STRCONST: at least one character, none of them a quote,
+        // tab, vertical tab, carriage return or newline
+        char* q = p + 1;
+        while ((q < end) && !strchr("\"\t\v\r\n", *q))
+          q++;
+        if ((q < end) && (*q == '"') && (q > p + 1))
+        {
+          value->text.start = p;
+          value->text.length = q + 1 - p;
+          return(finish(p, q + 1 - p, "STRCONST", T_STRCONST));
+        }
+        break;
+      }
+      case '(': return(finish(p, 1, "LPAREN", T_LPAREN));
+      case ')': return(finish(p, 1, "RPAREN", T_RPAREN));
+      case '{': return(finish(p, 1, "LBRACE", T_LBRACE));
+      case '}': return(finish(p, 1, "RBRACE", T_RBRACE));
+      case '[': return(finish(p, 1, "LBRACKET", T_LBRACKET));
+      case ']': return(finish(p, 1, "RBRACKET", T_RBRACKET));
+      case '+': return(finish(p, 1, "ADD", T_ADD));
+      case '-': return(finish(p, 1, "SUB", T_SUB));
+      case '*': return(finish(p, 1, "MULT", T_MULT));
+      case '/': return(finish(p, 1, "DIV", T_DIV));
+      case '^': return(finish(p, 1, "POWER", T_POW));
+      case '&': return(finish(p, 1, "AND", T_AND));
+      case '|': return(finish(p, 1, "OR", T_OR));
+      case ';': return(finish(p, 1, "SEMICOLON", T_SEMICOLON));
+      case ',': return(finish(p, 1, "COMMA", T_COMMA));
+      case '%':
+        if (p[1] == '%')
+          return(finish(p, 2, "MOD", T_MOD));
+        break;
+      case '<':
+        return((p[1] == '=') ? finish(p, 2, "LE", T_LE) : finish(p, 1, "LT", T_LT));
+      case '>':
+        return((p[1] == '=') ? finish(p, 2, "GE", T_GE) : finish(p, 1, "GT", T_GT));
+      case '=':
+        return((p[1] == '=') ? finish(p, 2, "EQ", T_EQ) : finish(p, 1, "ASSIGN", T_ASSIGN));
+      case '!':
+        return((p[1] == '=') ? finish(p, 2, "NE", T_NE) : finish(p, 1, "NOT", T_NOT));
+    }
+    return(finish(p, 1, "UNKNOWN", T_UNKNOWN));
+  }
+
+};
+
+#endif  // FAST_SCANNER_H
@@ -0,0 +1,218 @@
+#ifndef INTERPRETER_H
+#define INTERPRETER_H
+
+#include <stdio.h>
+#include <iostream>
+#include <stack>
+#include <string>
+#include <stdexcept>
+#include <functional>
+#include "SymbolTable.h"
+#include "CsvReader.h"
+#include "TokenCache.h"
+using namespace std;
+
+// A syntax or semantic error. The interpreter reports it as
+// "Line <line>: <message>".
+class MINIR_ERROR : public runtime_error
+{
+private:
+  int line;
+
+public:
+  //Constructor
+  MINIR_ERROR(const int theLine, const string theMessage)
+    : runtime_error(theMessage), line(theLine) { }
+
+  // Accessors
+  int getLine() const { return line; }
+};
+
+// Thrown by quit() to end the script.
+class MINIR_QUIT
+{
+};
+
+// INTERPRETER::scannerKind; SCANNER_FAST is the default
+#define SCANNER_FLEX   0    // the flex scanner in lex.yy.c
+#define SCANNER_SSE2   1    // FAST_SCANNER, 16 bytes at a time
+#define SCANNER_AVX2   2    // FAST_SCANNER, 32 bytes at a time
+#define SCANNER_FAST   3    // FAST_SCANNER, the widest the CPU has
+
+class FAST_SCANNER;
+
+// Receives the script's output, a piece at a time.
+typedef function<void(const char* text, size_t length)> OUTPUT_HANDLER;
+
+// Supplies one line for read(), without its newline. Returns false
+// at the end of the input.
+typedef function<bool(string& line)> INPUT_HANDLER;
+
+// The streambuf behind INTERPRETER::output: collects what the
+// grammar's actions write and passes it to an OUTPUT_HANDLER on
+// every flush (endl, a full buffer, or the end of a run).
+class OUTPUT_BUFFER : public streambuf
+{
+private:
+  char buffer[4096];
+  OUTPUT_HANDLER handler;
+
+public:
+  //Constructor
+  OUTPUT_BUFFER( ) { setp(buffer, buffer + sizeof(buffer)); }
+
+  void setHandler(const OUTPUT_HANDLER theHandler)
+  {
+    sync();
+    handler = theHandler;
+  }
+
+protected:
+  int overflow(int c)
+  {
+    sync();
+    if (c != EOF)
+    {
+      *pptr() = (char) c;
+      pbump(1);
+    }
+    return(c == EOF ? 0 : c);
+  }
+
+  int sync()
+  {
+    if ((pptr() > pbase()) && handler)
+      handler(pbase(), pptr() - pbase());
+    setp(buffer, buffer + sizeof(buffer));
+    return(0);
+  }
+};
+
+/*
+  All the state of running one script: the scopes, the line being
+  scanned and the parser's bookkeeping. The parser and scanner are
+  reentrant and keep nothing else, so separate INTERPRETERs can run
+  on separate threads. (-DPROFILE_RULES counts per thread, and
+  prints the sum at exit.)
+
+  The script's output goes to output, and read() takes its input
+  from readLine(); by default they are stdout and stdin, and
+  setOutputHandler()/setInputHandler() redirect them.
+
+  The grammar's actions in hol.y work on these members directly; the
+  member functions are defined there too. minir.h is the interface
+  for programs that embed the interpreter.
+*/
+class INTERPRETER
+{
+public:
+  stack<SYMBOL_TABLE> scopeStack; // stack of scope hashtables
+  CSV_TABLE csvTable;             // columns of the last file readCSV() read
+  int lineNum;                    // line the scanner is on
+  int numExprs;                   // # of arguments in the call being parsed
+  TYPE_INFO result;               // value of the last top-level expression
+  bool printResults;              // print each top-level expression's value
+  string cacheDir;                // where to keep scanned tokens, if anywhere
+  TOKEN_STREAM* tokens;           // cached tokens the parser is reading, if any
+  int scannerKind;                // which scanner to use, a SCANNER_ code
+  FAST_SCANNER* fastScanner;      // the hand-written scanner, if in use
+  string pendingError;            // error yylex() throws after the next token
+
+private:
+  OUTPUT_BUFFER outputBuffer;
+  INPUT_HANDLER inputHandler;
+
+public:
+  ostream output;                 // everything the script prints
+
+  //Constructor
+  INTERPRETER( ) : lineNum(1), numExprs(0), printResults(true),
+                   tokens(NULL), scannerKind(SCANNER_FAST), fastScanner(NULL),
+                   output(&outputBuffer)
+  {
+    result.type = NULL_TYPE;
+    result.listValue = NULL;
+    setOutputHandler(OUTPUT_HANDLER());
+    setInputHandler(INPUT_HANDLER());
+  }
+
+  ~INTERPRETER( ) { output.flush(); }
+
+  // Run the script in file: one top-level expression (join several
+  // with { ; }), which ends early at a quit() or an error, reported
+  // on output. Anything after that expression is not parsed. Returns
+  // 0 if the expression ran to its end, or 1 otherwise (the exit
+  // status the parser has always had).
+  // With a cacheDir, the script's tokens are saved there, and taken
+  // from there instead of scanned the next time.
+  int run(FILE* file);
+
+  // Run the script in the file named fileName as run() does, with
+  // the file mapped into memory rather than read.
+  int runFile(const string fileName);
+
+  // Run the script in source against the variables left by earlier
+  // calls, the way run() does: only its first top-level expression.
+  // Returns 0 or 1 as run() does.
+  int evaluate(const string source);
+
+  // Send output to handler; an empty handler means stdout.
+  void setOutputHandler(const OUTPUT_HANDLER handler);
+
+  // Take read()'s input from handler; an empty handler means stdin.
+  void setInputHandler(const INPUT_HANDLER handler);
+
+  // Give the variable name value in the outermost scope (the one
+  // evaluate() keeps between calls), adding it if it is not there. A LIST value's list is copied; one with no
+  // list starts out empty.
+  void setVariable(const string name, const TYPE_INFO value);
+
+  // Return name's TYPE_INFO as findEntryInAnyScope() does. Its
+  // listValue is the variable's own list, not a copy.
+  TYPE_INFO getVariable(const string name) { return(findEntryInAnyScope(name)); }
+
+  // Return the list that name holds, to read or fill in place, or
+  // NULL if name is not a list. It stays the variable's list until
+  // the variable is next assigned.
+  vector<TYPE>* getList(const string name);
+
+  // Read one line of input into line.
+  // If successful, return true; otherwise, return false.
+  bool readLine(string& line) { return(inputHandler(line)); }
+
+  // Push a new SYMBOL_TABLE onto scopeStack.
+  void beginScope();
+
+  // Pop a SYMBOL_TABLE from scopeStack.
+  void endScope();
+
+  // Pop all SYMBOL_TABLE's from scopeStack.
+  void cleanUp();
+
+  // If the_name exists in any SYMBOL_TABLE in scopeStack, return
+  // its TYPE_INFO; otherwise, return a TYPE_INFO that contains
+  // type UNDEFINED.
+  TYPE_INFO findEntryInAnyScope(const string the_name);
+
+  // Throw a MINIR_ERROR with the message for errNum (an index into
+  // ERR_MSG[]) about argument argNum (0 if none).
+  void semanticError(const int argNum, const int errNum);
+
+private:
+  // Run the size bytes of script at buffer, which are followed by
+  // two NULs for flex.
+  int evaluateBuffer(char* buffer, const size_t size);
+
+  // Parse the top-level expression scanner reads.
+  int parse(void* scanner);
+
+  // Fill stream with every token scanner produces.
+  void scanAll(void* scanner, TOKEN_STREAM& stream);
+
+  TYPE_INFO findEntryInScopes(const string the_name, int& numScopes);
+
+  void setInOutermostScope(const SYMBOL_TABLE_ENTRY& entry);
+
+};
+
+#endif  // INTERPRETER_H
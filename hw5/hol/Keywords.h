@@ -0,0 +1,109 @@
+#ifndef KEYWORDS_H
+#define KEYWORDS_H
+
+/*
+  The keywords, and a perfect hash that tells one from any other
+  identifier with a single probe and compare. hol.l scans every
+  identifier with its one IDENT rule and looks it up here, instead
+  of having a rule per keyword, each of which added a DFA state per
+  character; FAST_SCANNER looks identifiers up the same way.
+
+  The hash mixes an identifier's length with its first, last and
+  next-to-last characters. The slot table is built from KEYWORDS at
+  compile time, and a static_assert stops the build if two keywords
+  share a slot; a new keyword that does needs new KEYWORD_HASH_
+  multipliers.
+
+  It uses the T_ token codes from hol.y, so hol.l includes it.
+*/
+
+#include <string.h>
+using namespace std;
+
+#define KEYWORD_SLOTS        32   // a power of 2
+#define KEYWORD_HASH_FIRST   12
+#define KEYWORD_HASH_LAST    30
+#define KEYWORD_HASH_PENULT  8
+
+typedef struct {
+  const char* text;
+  int token;
+  const char* name;     // for printTokenInfo()
+} KEYWORD;
+
+constexpr KEYWORD KEYWORDS[] = {
+  {"TRUE", T_TRUE, "TRUE"}, {"FALSE", T_FALSE, "FALSE"},
+  {"if", T_IF, "IF"}, {"else", T_ELSE, "ELSE"}, {"while", T_WHILE, "WHILE"},
+  {"function", T_FUNCTION, "FUNCTION"}, {"for", T_FOR, "FOR"}, {"in", T_IN, "IN"},
+  {"quit", T_QUIT, "QUIT"}, {"print", T_PRINT, "PRINT"}, {"cat", T_CAT, "CAT"},
+  {"read", T_READ, "READ"}, {"list", T_LIST, "LIST"}, {"scan", T_SCAN, "SCAN"},
+  {"readLines", T_READLINES, "READLINES"}, {"readCSV", T_READCSV, "READCSV"},
+  {"saveRDS", T_SAVERDS, "SAVERDS"}, {"readRDS", T_READRDS, "READRDS"}
+};
+constexpr int NUM_KEYWORDS = sizeof(KEYWORDS) / sizeof(KEYWORDS[0]);
+
+constexpr int keywordLength(const char* text, const int i = 0)
+{
+  return((text[i] == '\0') ? i : keywordLength(text, i + 1));
+}
+
+// Return the slot of the identifier of length (at least 2) at text.
+constexpr int keywordHash(const char* text, const int length)
+{
+  return((length
+          + KEYWORD_HASH_FIRST * (unsigned char) text[0]
+          + KEYWORD_HASH_LAST * (unsigned char) text[length - 1]
+          + KEYWORD_HASH_PENULT * (unsigned char) text[length - 2])
+         & (KEYWORD_SLOTS - 1));
+}
+
+constexpr int keywordSlot(const int i)
+{
+  return(keywordHash(KEYWORDS[i].text, keywordLength(KEYWORDS[i].text)));
+}
+
+// Return the index of the keyword from the ith on in slot, or -1.
+constexpr int keywordInSlot(const int slot, const int i = 0)
+{
+  return((i == NUM_KEYWORDS) ? -1
+         : (keywordSlot(i) == slot) ? i
+         : keywordInSlot(slot, i + 1));
+}
+
+// Return whether each keyword from the ith on has a slot of its own
+// and at least the 2 characters the hash reads.
+constexpr bool keywordsArePerfect(const int i = 0)
+{
+  return((i == NUM_KEYWORDS)
+         || ((keywordLength(KEYWORDS[i].text) >= 2)
+             && (keywordInSlot(keywordSlot(i)) == i)
+             && keywordsArePerfect(i + 1)));
+}
+
+static_assert(keywordsArePerfect(), "two keywords share a slot; change the KEYWORD_HASH_ multipliers");
+
+#define KEYWORD_SLOTS_4(n) \
+  keywordInSlot(n), keywordInSlot(n + 1), keywordInSlot(n + 2), keywordInSlot(n + 3)
+#define KEYWORD_SLOTS_16(n) \
+  KEYWORD_SLOTS_4(n), KEYWORD_SLOTS_4(n + 4), KEYWORD_SLOTS_4(n + 8), KEYWORD_SLOTS_4(n + 12)
+
+// slot -> index into KEYWORDS, or -1
+constexpr signed char KEYWORD_TABLE[KEYWORD_SLOTS] = {
+  KEYWORD_SLOTS_16(0), KEYWORD_SLOTS_16(16)
+};
+static_assert(KEYWORD_SLOTS == 32, "KEYWORD_TABLE lists 32 slots");
+
+// Return the keyword the identifier of length at text is, or NULL
+// if it is not one.
+inline const KEYWORD* findKeyword(const char* text, const int length)
+{
+  if (length < 2)
+    return(NULL);
+  int i = KEYWORD_TABLE[keywordHash(text, length)];
+  if ((i < 0) || (strncmp(KEYWORDS[i].text, text, length) != 0)
+  || (KEYWORDS[i].text[length] != '\0'))
+    return(NULL);
+  return(&KEYWORDS[i]);
+}
+
+#endif  // KEYWORDS_H
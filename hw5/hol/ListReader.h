@@ -0,0 +1,212 @@
+#ifndef LIST_READER_H
+#define LIST_READER_H
+
+/*
+  The readers behind scan() and readLines(). Each maps its file with
+  MAPPED_FILE and builds the list's elements straight from the
+  mapping; only the search for the end of a value uses SSE2.
+
+  Every element is a whole TYPE (sizeof(TYPE) is 276 bytes), whatever
+  its type, so a list takes about 35 times the space of the numbers
+  in it: a file of a few hundred MB is the practical limit, not
+  several GB. A STR element, or a line, can hold 255 characters, and
+  a longer one is an error rather than cut short.
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "SymbolTableEntry.h"
+#include "MappedFile.h"
+#include "Literals.h"
+using namespace std;
+
+// Determine whether c is a blank, tab, newline, vertical tab,
+// form feed, or carriage return.
+inline bool isSpaceChar(const char c)
+{
+    return((c == ' ') || ((unsigned char)(c - '\t') <= 4));
+}
+
+// Return a pointer to the first whitespace character in [p, end),
+// or end if there is none. Checks 16 bytes per step when SSE2
+// is available.
+inline const char* findSpace(const char* p, const char* end)
+{
+#ifdef __SSE2__
+    const __m128i blank = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i four = _mm_set1_epi8(4);
+    while (end - p >= 16)
+    {
+        __m128i chunk = _mm_loadu_si128((const __m128i*) p);
+        // '\t' through '\r' are contiguous, so (c - '\t') <= 4
+        // as an unsigned compare picks out all of them at once
+        __m128i offset = _mm_sub_epi8(chunk, tab);
+        __m128i isCtrl = _mm_cmpeq_epi8(_mm_min_epu8(offset, four), offset);
+        __m128i isBlank = _mm_cmpeq_epi8(chunk, blank);
+        int mask = _mm_movemask_epi8(_mm_or_si128(isCtrl, isBlank));
+        if (mask != 0)
+            return(p + __builtin_ctz(mask));
+        p += 16;
+    }
+#endif
+    while ((p < end) && !isSpaceChar(*p))
+        p++;
+    return(p);
+}
+
+// Return the type code (INT, FLOAT, BOOL or STR) the lexer would
+// give the len characters at p.
+inline int classifyText(const char* p, size_t len)
+{
+    size_t i = 0;
+    if ((len > 0) && ((p[0] == '+') || (p[0] == '-')))
+        i++;
+    size_t intDigits = 0;
+    while ((i < len) && isdigit((unsigned char) p[i]))
+    {
+        i++;
+        intDigits++;
+    }
+
+    if ((i == len) && (intDigits > 0))
+        return(INT);
+    if ((i < len) && (p[i] == '.'))
+    {
+        size_t fracDigits = 0;
+        i++;
+        while ((i < len) && isdigit((unsigned char) p[i]))
+        {
+            i++;
+            fracDigits++;
+        }
+        if ((i == len) && (fracDigits > 0))
+            return(FLOAT);
+    }
+    if (((len == 4) && (memcmp(p, "TRUE", 4) == 0))
+    || ((len == 5) && (memcmp(p, "FALSE", 5) == 0)))
+        return(BOOL);
+    return(STR);
+}
+
+// Determine whether the len characters of a STR fit in a TYPE's
+// stringValue, with its NUL.
+inline bool fitsStringValue(const size_t len)
+{
+    return(len < sizeof(((TYPE*) NULL)->stringValue));
+}
+
+// Build into element a list element of type theType from the len
+// characters at p. INT text may be stored as a FLOAT.
+// Return 0 if successful, 1 if a number is out of its type's range,
+// or 2 if a STR is too long.
+inline int makeTypedElement(const char* p, size_t len, const int theType,
+                            TYPE& element)
+{
+    memset(&element, 0, sizeof(element));
+    element.type = theType;
+    if (theType == INT)
+        return(parseIntLiteral(p, len, element.intValue) ? 0 : 1);
+    if (theType == FLOAT)
+    {
+        // an INT's text converts as a FLOAT's does
+        return(parseFloatLiteral(p, len, element.floatValue) ? 0 : 1);
+    }
+    if (theType == BOOL)
+        element.boolValue = (p[0] == 'T');
+    else
+    {
+        if (!fitsStringValue(len))
+            return(2);
+        memcpy(element.stringValue, p, len);
+        element.stringValue[len] = '\0';
+    }
+    return(0);
+}
+
+// Build into element a list element from the len characters at
+// p, using the same INT/FLOAT/BOOL rules as the lexer and treating
+// anything else as a STR. Returns what makeTypedElement() does.
+inline int makeListElement(const char* p, size_t len, TYPE& element)
+{
+    return(makeTypedElement(p, len, classifyText(p, len), element));
+}
+
+// Read every whitespace-separated value in the file named
+// fileName and append it to values.
+// Return 0 if successful, -1 if the file cannot be opened, 1 if a
+// number in it is out of range, or 2 if a string in it is too long.
+inline int scanFile(const char* fileName, vector<TYPE>* values)
+{
+    MAPPED_FILE file;
+    if (!file.open(fileName))
+        return(-1);
+
+    const char* p = file.getData();
+    const char* end = p + file.getSize();
+    TYPE element;
+    while (p < end)
+    {
+        while ((p < end) && isSpaceChar(*p))
+            p++;
+        if (p == end)
+            break;
+        const char* tokenEnd = findSpace(p, end);
+        int status = makeListElement(p, tokenEnd - p, element);
+        if (status != 0)
+            return(status);
+        values->push_back(element);
+        p = tokenEnd;
+    }
+    return(0);
+}
+
+// Read every line of the file named fileName and append it to
+// values as a STR, without its line terminator.
+// Return 0 if successful, -1 if the file cannot be opened, or 2 if
+// a line in it is too long.
+inline int readLinesFile(const char* fileName, vector<TYPE>* values)
+{
+    MAPPED_FILE file;
+    if (!file.open(fileName))
+        return(-1);
+
+    const char* p = file.getData();
+    const char* end = p + file.getSize();
+
+    // one pass over the newlines (memchr is vectorized) so the
+    // storage is only allocated once
+    size_t numLines = 0;
+    for (const char* q = p; q < end; numLines++)
+    {
+        const char* nl = (const char*) memchr(q, '\n', end - q);
+        q = (nl == NULL) ? end : nl + 1;
+    }
+    values->reserve(values->size() + numLines);
+
+    TYPE element;
+    memset(&element, 0, sizeof(element));
+    element.type = STR;
+    while (p < end)
+    {
+        const char* nl = (const char*) memchr(p, '\n', end - p);
+        const char* lineEnd = (nl == NULL) ? end : nl;
+        size_t len = lineEnd - p;
+        if ((len > 0) && (p[len - 1] == '\r'))
+            len--;
+        if (!fitsStringValue(len))
+            return(2);
+        memcpy(element.stringValue, p, len);
+        element.stringValue[len] = '\0';
+        values->push_back(element);
+        p = (nl == NULL) ? end : nl + 1;
+    }
+    return(0);
+}
+
+#endif  // LIST_READER_H
@@ -0,0 +1,177 @@
+#ifndef LIST_STORE_H
+#define LIST_STORE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "SymbolTableEntry.h"
+#include "MappedFile.h"
+using namespace std;
+
+// Bump LIST_STORE_VERSION whenever the layout below or TYPE changes.
+#define LIST_STORE_MAGIC      "MINIRDS"
+#define LIST_STORE_VERSION    3
+#define LIST_STORE_ALIGNMENT  64
+
+// The header at the start of a saved value. The elements follow
+// at dataOffset as an array of TYPE, exactly as held in memory.
+typedef struct {
+  char magic[8];        // LIST_STORE_MAGIC
+  int version;          // LIST_STORE_VERSION
+  int type;             // type code of the saved value
+  long long length;     // # of elements (1 for a scalar)
+  int elementSize;      // sizeof(TYPE) of the writer
+  int dataOffset;       // multiple of LIST_STORE_ALIGNMENT
+} LIST_STORE_HEADER;
+
+// Fill in a header for a value of type theType with theLength
+// elements.
+inline LIST_STORE_HEADER makeListStoreHeader(const int theType,
+                                             const long long theLength)
+{
+  LIST_STORE_HEADER header;
+  memset(&header, 0, sizeof(header));
+  strcpy(header.magic, LIST_STORE_MAGIC);
+  header.version = LIST_STORE_VERSION;
+  header.type = theType;
+  header.length = theLength;
+  header.elementSize = sizeof(TYPE);
+  header.dataOffset = LIST_STORE_ALIGNMENT;
+  return(header);
+}
+
+// Determine whether theType is the type code of a list element:
+// INT, FLOAT, BOOL or STR.
+inline bool isStorableElementType(const int theType)
+{
+  return((theType == INT) || (theType == FLOAT) || (theType == BOOL)
+         || (theType == STR));
+}
+
+// Determine whether the size bytes at data start with a header this
+// build can read, and are long enough to hold what it describes.
+// The header comes from a file, so each field is range-checked
+// before it is used.
+inline bool isValidListStore(const char* data, const size_t size)
+{
+  if (size < sizeof(LIST_STORE_HEADER))
+    return(false);
+  const LIST_STORE_HEADER* header = (const LIST_STORE_HEADER*) data;
+  if ((memcmp(header->magic, LIST_STORE_MAGIC, sizeof(LIST_STORE_MAGIC)) != 0)
+  || (header->version != LIST_STORE_VERSION)
+  || (header->elementSize != (int) sizeof(TYPE))
+  || ((header->type != LIST) && !isStorableElementType(header->type))
+  || (header->dataOffset < (int) sizeof(LIST_STORE_HEADER))
+  || ((size_t) header->dataOffset > size)
+  || (header->dataOffset % LIST_STORE_ALIGNMENT != 0)
+  || (header->length < 0)
+  || ((unsigned long long) header->length > SIZE_MAX / sizeof(TYPE)))
+    return(false);
+  return((size_t) header->length * sizeof(TYPE) <= size - header->dataOffset);
+}
+
+// Determine whether element, read from a file, is one a list can hold: of an element type, and with its
+// stringValue NUL-terminated.
+inline bool isValidStoredElement(const TYPE& element)
+{
+  return(isStorableElementType(element.type)
+         && (memchr(element.stringValue, '\0', sizeof(element.stringValue)) != NULL));
+}
+
+// Return a copy of element, of type theType, with every byte that
+// is not part of its value (padding, and stringValue past its NUL)
+// zeroed, so nothing left over in memory is written out.
+inline TYPE makeStoredElement(const TYPE& element, const int theType)
+{
+  TYPE stored;
+  memset(&stored, 0, sizeof(stored));
+  stored.type = theType;
+  stored.intValue = element.intValue;
+  stored.op = element.op;
+  stored.floatValue = element.floatValue;
+  stored.boolValue = element.boolValue;
+  memcpy(stored.stringValue, element.stringValue,
+         strnlen(element.stringValue, sizeof(stored.stringValue) - 1));
+  return(stored);
+}
+
+// Copy the length elements of value, of type theType (one element,
+// value itself, if it is not a LIST), into out as
+// makeStoredElement() leaves them.
+inline void copyStoredElements(const int theType, const TYPE& value,
+                               const vector<TYPE>* listValue, TYPE* out)
+{
+  if (theType != LIST)
+    out[0] = makeStoredElement(value, theType);
+  else
+    for (size_t i = 0; i < listValue->size(); i++)
+      out[i] = makeStoredElement((*listValue)[i], (*listValue)[i].type);
+}
+
+// Write value, of type theType, to the file named fileName. A LIST
+// writes its elements; any other type writes value itself.
+// If successful, return true; otherwise, return false.
+inline bool saveValue(const char* fileName, const int theType,
+                      const TYPE& value, const vector<TYPE>* listValue)
+{
+  FILE* out = fopen(fileName, "wb");
+  if (out == NULL)
+    return(false);
+
+  long long length = (theType == LIST) ? listValue->size() : 1;
+  LIST_STORE_HEADER header = makeListStoreHeader(theType, length);
+  char block[LIST_STORE_ALIGNMENT];
+  memset(block, 0, sizeof(block));
+  memcpy(block, &header, sizeof(header));
+
+  bool ok = (fwrite(block, sizeof(block), 1, out) == 1);
+  vector<TYPE> elements(length);
+  if (length > 0)
+  {
+    copyStoredElements(theType, value, listValue, elements.data());
+    ok = ok && (fwrite(elements.data(), sizeof(TYPE), length, out) == (size_t) length);
+  }
+  return((fclose(out) == 0) && ok);
+}
+
+// Read the value held in the size bytes at data. The elements are
+// taken as they are, with nothing parsed, and copied once into a new
+// list: a list is a vector<TYPE> the interpreter owns (and copies on
+// assignment), so it cannot be left in data. Returns 0 if
+// successful, or -2 if it isn't a value this build can read.
+inline int readListStore(const char* data, const size_t size, int* theType,
+                         TYPE* value, vector<TYPE>** listValue)
+{
+  if (!isValidListStore(data, size))
+    return(-2);
+
+  const LIST_STORE_HEADER* header = (const LIST_STORE_HEADER*) data;
+  const TYPE* elements = (const TYPE*) (data + header->dataOffset);
+  for (long long i = 0; i < header->length; i++)
+    if (!isValidStoredElement(elements[i])
+    || ((header->type != LIST) && (elements[i].type != header->type)))
+      return(-2);
+  if (header->type == LIST)
+    *listValue = new vector<TYPE>(elements, elements + header->length);
+  else if (header->length == 1)
+    *value = elements[0];
+  else
+    return(-2);
+  *theType = header->type;
+  return(0);
+}
+
+// Read a value written by saveValue from the file named fileName,
+// which is mapped rather than read. Returns 0 if successful, -1 if the file can't be opened, or -2
+// if it isn't a value this build can read.
+inline int loadValue(const char* fileName, int* theType, TYPE* value,
+                     vector<TYPE>** listValue)
+{
+  MAPPED_FILE file;
+  if (!file.open(fileName))
+    return(-1);
+  return(readListStore(file.getData(), file.getSize(), theType, value, listValue));
+}
+
+#endif  // LIST_STORE_H
@@ -0,0 +1,103 @@
+#ifndef LITERALS_H
+#define LITERALS_H
+
+/*
+  Conversion of INTCONST and FLOATCONST text to values, straight
+  from the script's buffer: the text need not end in a NUL, the
+  locale is never consulted, and a literal too large for its type
+  is reported rather than wrapped.
+
+  A FLOATCONST is converted as atof() did, to the nearest double
+  and then to float. When its significant digits fit in 53 bits
+  and it has at most 22 of them after the point, the nearest double
+  is the digits divided by a power of ten, both exact in a double,
+  so one division rounds it correctly (Clinger's fast path). Longer
+  literals are rare and go to strtod_l() in the C locale.
+*/
+
+#include <limits.h>
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+using namespace std;
+
+#define NUMBER_RANGE_MESSAGE  "Number out of range"
+
+#define FAST_PATH_MAX_MANTISSA  (1ULL << 53)
+#define FAST_PATH_MAX_EXPONENT  22
+
+// Convert the INTCONST ([+-]?[0-9]+) of length at text to value.
+// If it fits in an int, return true; otherwise, return false.
+inline bool parseIntLiteral(const char* text, const int length, int& value)
+{
+  const char* p = text;
+  const char* end = text + length;
+  bool negative = (*p == '-');
+  if ((*p == '+') || (*p == '-'))
+    p++;
+  // INT_MIN is one further from 0 than INT_MAX
+  const uint64_t limit = negative ? (uint64_t) INT_MAX + 1 : (uint64_t) INT_MAX;
+  uint64_t n = 0;
+  for (; p < end; p++)
+  {
+    n = n * 10 + (*p - '0');
+    if (n > limit)
+      return(false);
+  }
+  value = negative ? (int) -(int64_t) n : (int) n;
+  return(true);
+}
+
+// Convert the FLOATCONST ([+-]?[0-9]*\.[0-9]+) of length at text to
+// value.
+// If it is within float's range, return true; otherwise (it is too
+// large, or not 0 but rounds to 0), return false.
+inline bool parseFloatLiteral(const char* text, const int length, float& value)
+{
+  static const double POWERS_OF_10[FAST_PATH_MAX_EXPONENT + 1] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char* p = text;
+  const char* end = text + length;
+  bool negative = (*p == '-');
+  if ((*p == '+') || (*p == '-'))
+    p++;
+
+  uint64_t mantissa = 0;
+  int numFractionDigits = 0;
+  bool inFraction = false;
+  bool exact = true;        // mantissa holds every digit
+  bool isZero = true;
+  for (; p < end; p++)
+  {
+    if (*p == '.')
+    {
+      inFraction = true;
+      continue;
+    }
+    if (*p != '0')
+      isZero = false;
+    if (mantissa <= (FAST_PATH_MAX_MANTISSA - 9) / 10)
+      mantissa = mantissa * 10 + (*p - '0');
+    else
+      exact = false;
+    numFractionDigits += inFraction;
+  }
+
+  double d;
+  if (exact && (numFractionDigits <= FAST_PATH_MAX_EXPONENT))
+    d = (double) mantissa / POWERS_OF_10[numFractionDigits];
+  else
+  {
+    static locale_t cLocale = newlocale(LC_ALL_MASK, "C", (locale_t) 0);
+    string copy(text, length);
+    d = fabs(strtod_l(copy.c_str(), NULL, cLocale));
+  }
+  value = (float) (negative ? -d : d);
+  return(!isinf(value) && (isZero || (value != 0)));
+}
+
+#endif  // LITERALS_H
@@ -0,0 +1,121 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+using namespace std;
+
+// A read-only, memory-mapped view of an entire file.
+class MAPPED_FILE
+{
+private:
+  const char* data;
+  size_t size;
+  size_t mappedSize;    // size plus any padding
+
+  // not copyable; the mapping is released by the destructor
+  MAPPED_FILE(const MAPPED_FILE&);
+  MAPPED_FILE& operator=(const MAPPED_FILE&);
+
+public:
+  //Constructor
+  MAPPED_FILE( ) : data(NULL), size(0), mappedSize(0) { }
+
+  ~MAPPED_FILE( ) { close(); }
+
+  // Map the file named fileName into memory.
+  // If successful, return true; otherwise, return false.
+  bool open(const char* fileName)
+  {
+    close();
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0)
+      return(false);
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+      ::close(fd);
+      return(false);
+    }
+
+    // an empty file is a valid, empty mapping
+    if (st.st_size > 0)
+    {
+      void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (p == MAP_FAILED)
+      {
+        ::close(fd);
+        return(false);
+      }
+      madvise(p, st.st_size, MADV_SEQUENTIAL);
+      data = (const char*) p;
+      size = st.st_size;
+      mappedSize = size;
+    }
+    ::close(fd);
+    return(true);
+  }
+
+  // Map the file named fileName copy-on-write, followed by padding
+  // zero bytes, for a reader such as flex's yy_scan_buffer() that
+  // writes into its buffer and needs it terminated. The file itself
+  // never changes.
+  // If successful, return true; otherwise, return false.
+  bool openPadded(const char* fileName, const size_t padding)
+  {
+    close();
+    int fd = ::open(fileName, O_RDONLY);
+    if (fd < 0)
+      return(false);
+
+    struct stat st;
+    if ((fstat(fd, &st) != 0) || !S_ISREG(st.st_mode))
+    {
+      ::close(fd);
+      return(false);
+    }
+
+    // zero pages for all of it, then the file over the front; the
+    // padding past the file's last page stays anonymous, so it
+    // cannot fault even when the file ends on a page boundary
+    size_t length = st.st_size + padding;
+    void* p = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if ((p != MAP_FAILED) && (st.st_size > 0)
+    && (mmap(p, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0)
+        == MAP_FAILED))
+    {
+      munmap(p, length);
+      p = MAP_FAILED;
+    }
+    ::close(fd);
+    if (p == MAP_FAILED)
+      return(false);
+    madvise(p, length, MADV_SEQUENTIAL);
+    data = (const char*) p;
+    size = st.st_size;
+    mappedSize = length;
+    return(true);
+  }
+
+  // Release the mapping, if any.
+  void close()
+  {
+    if (data != NULL)
+      munmap((void*) data, mappedSize);
+    data = NULL;
+    size = 0;
+    mappedSize = 0;
+  }
+
+  // Accessors
+  const char* getData() const { return data; }
+  size_t getSize() const { return size; }
+
+};
+
+#endif  // MAPPED_FILE_H
@@ -0,0 +1,251 @@
+#ifndef OPERATORS_H
+#define OPERATORS_H
+
+/*
+  The binary operators, as one table of kernels indexed by operator
+  and by the tags of the two operands, so that applying one is a
+  single indirect call and every operator treats every pair of
+  operand types alike:
+
+    - A BOOL operand counts as the INT 0 or 1, as in R, so TRUE + TRUE
+      is 2. (The original parser gave a BOOL for any + - * / %% ^
+      with a BOOL operand, taken from the left operand's boolValue
+      field, so TRUE + 3 was TRUE and 3 + TRUE FALSE.)
+    - + - * / %% ^ give a FLOAT if either operand is a FLOAT, and an
+      INT otherwise.
+    - < > <= >= == != compare the operands as that same type and
+      give a BOOL.
+    - | and & give a BOOL: whether either, or both, are nonzero.
+    - / and %% by zero are errors, and so is an INT + - * / or ^
+      whose result is not an INT; an INT ^ is truncated.
+
+  Each kernel is binaryKernel<op, left tag, right tag>, built from
+  the OPERATOR<op> and OPERAND<tag> templates below.
+
+  It uses the operator codes, ERR_ codes and INTERPRETER from
+  hol.y, so hol.y includes it after them.
+*/
+
+#include <limits.h>
+#include <math.h>
+#include "SymbolTableEntry.h"
+#include "Interpreter.h"
+using namespace std;
+
+// operand tags: the index of an operand's type in the table
+#define TAG_INT        0
+#define TAG_FLOAT      1
+#define TAG_BOOL       2
+#define NUM_TAGS       3
+
+#define FIRST_OPERATOR ADD
+#define LAST_OPERATOR  NE
+#define NUM_OPERATORS  (LAST_OPERATOR - FIRST_OPERATOR + 1)
+
+typedef void (*BINARY_KERNEL)(INTERPRETER& interpreter, const TYPE& left,
+                              const TYPE& right, TYPE& result);
+
+// The C++ type an operand of tag TAG is read as, and how.
+template <int TAG> struct OPERAND;
+
+template <> struct OPERAND<TAG_INT>
+{
+  typedef int VALUE;
+  static int read(const TYPE& x) { return(x.intValue); }
+};
+
+template <> struct OPERAND<TAG_FLOAT>
+{
+  typedef float VALUE;
+  static float read(const TYPE& x) { return(x.floatValue); }
+};
+
+template <> struct OPERAND<TAG_BOOL>
+{
+  typedef int VALUE;
+  static int read(const TYPE& x) { return(x.boolValue ? 1 : 0); }
+};
+
+// The tag operands of tags LEFT and RIGHT are both converted to.
+template <int LEFT, int RIGHT> struct PROMOTED
+{
+  static const int TAG = ((LEFT == TAG_FLOAT) || (RIGHT == TAG_FLOAT)) ? TAG_FLOAT : TAG_INT;
+};
+
+// Store x into result as an INT, FLOAT or BOOL.
+inline void storeValue(TYPE& result, const int x) { result.type = INT; result.intValue = x; }
+inline void storeValue(TYPE& result, const float x) { result.type = FLOAT; result.floatValue = x; }
+inline void storeValue(TYPE& result, const bool x) { result.type = BOOL; result.boolValue = x; }
+
+// What each operator does to two operands of the same C++ type T.
+// An operator is given the interpreter to report errors on.
+template <int OP> struct OPERATOR;
+
+// signed overflow is undefined, so INT + - * check for it
+template <> struct OPERATOR<ADD>
+{
+  static int apply(INTERPRETER& interpreter, const int a, const int b)
+  {
+    int x;
+    if (__builtin_add_overflow(a, b, &x))
+      interpreter.semanticError(0, ERR_NUMBER_OUT_OF_RANGE);
+    return(x);
+  }
+  static float apply(INTERPRETER&, const float a, const float b) { return(a + b); }
+};
+
+template <> struct OPERATOR<SUB>
+{
+  static int apply(INTERPRETER& interpreter, const int a, const int b)
+  {
+    int x;
+    if (__builtin_sub_overflow(a, b, &x))
+      interpreter.semanticError(0, ERR_NUMBER_OUT_OF_RANGE);
+    return(x);
+  }
+  static float apply(INTERPRETER&, const float a, const float b) { return(a - b); }
+};
+
+template <> struct OPERATOR<MULT>
+{
+  static int apply(INTERPRETER& interpreter, const int a, const int b)
+  {
+    int x;
+    if (__builtin_mul_overflow(a, b, &x))
+      interpreter.semanticError(0, ERR_NUMBER_OUT_OF_RANGE);
+    return(x);
+  }
+  static float apply(INTERPRETER&, const float a, const float b) { return(a * b); }
+};
+
+template <> struct OPERATOR<DIV>
+{
+  // INT_MIN / -1 is INT_MAX + 1, and traps
+  static int apply(INTERPRETER& interpreter, const int a, const int b)
+  {
+    if (b == 0)
+      interpreter.semanticError(0, ERR_ATTEMPTED_DIV_BY_ZERO);
+    if ((a == INT_MIN) && (b == -1))
+      interpreter.semanticError(0, ERR_NUMBER_OUT_OF_RANGE);
+    return(a / b);
+  }
+  static float apply(INTERPRETER& interpreter, const float a, const float b)
+  {
+    if (b == 0)
+      interpreter.semanticError(0, ERR_ATTEMPTED_DIV_BY_ZERO);
+    return(a / b);
+  }
+};
+
+template <> struct OPERATOR<MOD>
+{
+  // INT_MIN %% -1 is 0, but computing it traps as the division does
+  static int apply(INTERPRETER& interpreter, const int a, const int b)
+  {
+    if (b == 0)
+      interpreter.semanticError(0, ERR_ATTEMPTED_DIV_BY_ZERO);
+    if (b == -1)
+      return(0);
+    return(a % b);
+  }
+  static float apply(INTERPRETER& interpreter, const float a, const float b)
+  {
+    if (b == 0)
+      interpreter.semanticError(0, ERR_ATTEMPTED_DIV_BY_ZERO);
+    return(fmod(a, b));
+  }
+};
+
+template <> struct OPERATOR<POW>
+{
+  // converting a double outside int's range (or 0 ^ -1, an infinity)
+  // to int is undefined, so it is an error
+  static int apply(INTERPRETER& interpreter, const int a, const int b)
+  {
+    double x = pow((double) a, (double) b);
+    if (!(x >= (double) INT_MIN && x <= (double) INT_MAX))
+      interpreter.semanticError(0, ERR_NUMBER_OUT_OF_RANGE);
+    return((int) x);
+  }
+  static float apply(INTERPRETER&, const float a, const float b) { return(pow(a, b)); }
+};
+
+template <> struct OPERATOR<OR>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return((a != 0) || (b != 0)); }
+};
+
+template <> struct OPERATOR<AND>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return((a != 0) && (b != 0)); }
+};
+
+template <> struct OPERATOR<LT>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return(a < b); }
+};
+
+template <> struct OPERATOR<GT>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return(a > b); }
+};
+
+template <> struct OPERATOR<LE>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return(a <= b); }
+};
+
+template <> struct OPERATOR<GE>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return(a >= b); }
+};
+
+template <> struct OPERATOR<EQ>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return(a == b); }
+};
+
+template <> struct OPERATOR<NE>
+{
+  template <class T> static bool apply(INTERPRETER&, const T a, const T b) { return(a != b); }
+};
+
+// left OP right, for a left operand of tag LEFT and a right one of
+// tag RIGHT.
+template <int OP, int LEFT, int RIGHT>
+void binaryKernel(INTERPRETER& interpreter, const TYPE& left, const TYPE& right, TYPE& result)
+{
+  typedef typename OPERAND<PROMOTED<LEFT, RIGHT>::TAG>::VALUE VALUE;
+  storeValue(result, OPERATOR<OP>::apply(interpreter, (VALUE) OPERAND<LEFT>::read(left),
+                                         (VALUE) OPERAND<RIGHT>::read(right)));
+}
+
+#define KERNELS_FOR_LEFT(OP, LEFT) \
+  { &binaryKernel<OP, LEFT, TAG_INT>, &binaryKernel<OP, LEFT, TAG_FLOAT>, \
+    &binaryKernel<OP, LEFT, TAG_BOOL> }
+#define KERNELS_FOR(OP) \
+  { KERNELS_FOR_LEFT(OP, TAG_INT), KERNELS_FOR_LEFT(OP, TAG_FLOAT), \
+    KERNELS_FOR_LEFT(OP, TAG_BOOL) }
+
+// [op - FIRST_OPERATOR][left tag][right tag], in operator code order
+constexpr BINARY_KERNEL BINARY_KERNELS[NUM_OPERATORS][NUM_TAGS][NUM_TAGS] = {
+  KERNELS_FOR(ADD), KERNELS_FOR(SUB), KERNELS_FOR(OR), KERNELS_FOR(MULT),
+  KERNELS_FOR(DIV), KERNELS_FOR(AND), KERNELS_FOR(MOD), KERNELS_FOR(POW),
+  KERNELS_FOR(LT), KERNELS_FOR(GT), KERNELS_FOR(LE), KERNELS_FOR(GE),
+  KERNELS_FOR(EQ), KERNELS_FOR(NE)
+};
+
+static_assert((SUB == ADD + 1) && (OR == ADD + 2) && (MULT == ADD + 3) && (DIV == ADD + 4)
+              && (AND == ADD + 5) && (MOD == ADD + 6) && (POW == ADD + 7) && (LT == ADD + 8)
+              && (GT == ADD + 9) && (LE == ADD + 10) && (GE == ADD + 11) && (EQ == ADD + 12)
+              && (NE == ADD + 13),
+              "BINARY_KERNELS lists the operators in code order");
+
+// Return the tag of a value of type theType; anything but a FLOAT
+// or BOOL is read as an INT.
+inline int tagOf(const int theType)
+{
+  return((theType == FLOAT) ? TAG_FLOAT : (theType == BOOL) ? TAG_BOOL : TAG_INT);
+}
+
+#endif  // OPERATORS_H
@@ -0,0 +1,211 @@
+#ifndef RULE_PROFILER_H
+#define RULE_PROFILER_H
+
+/*
+  Per-production reduction counters, compiled in with -DPROFILE_RULES.
+  Without it, PROFILE_RULE and PROFILE_SCOPE_DEPTH expand to nothing.
+*/
+
+#ifdef PROFILE_RULES
+
+#include <stdio.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <mutex>
+using namespace std;
+
+typedef struct {
+  const char* lhs;
+  const char* rhs;
+  long long count;      // # of reductions
+  long long nanos;      // time until the next reduction
+} RULE_STATS;
+
+class RULE_PROFILER
+{
+private:
+  // keyed by the string literals printRule is called with, so
+  // counting a reduction never builds a string
+  map<pair<const char*, const char*>, RULE_STATS> rules;
+  vector<long long> scopeDepths;  // scopeDepths[d] = # lookups that walked d scopes
+  RULE_STATS* lastRule;
+  long long lastTime;
+
+  static long long now()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((long long) ts.tv_sec * 1000000000LL + ts.tv_nsec);
+  }
+
+  static bool byCount(const RULE_STATS& a, const RULE_STATS& b)
+  {
+    return(a.count > b.count);
+  }
+
+public:
+  //Constructor
+  RULE_PROFILER( ) : lastRule(NULL), lastTime(0) { }
+
+  // Count one reduction of lhs -> rhs. The time from here to the
+  // next reduction (its action, plus any scanning before the next
+  // reduction) is charged to this production.
+  void countRule(const char* lhs, const char* rhs)
+  {
+    long long t = now();
+    if (lastRule != NULL)
+      lastRule->nanos += t - lastTime;
+
+    RULE_STATS& stats = rules[make_pair(lhs, rhs)];
+    if (stats.count == 0)
+    {
+      stats.lhs = lhs;
+      stats.rhs = rhs;
+    }
+    stats.count++;
+    lastRule = &stats;
+    lastTime = t;
+  }
+
+  // Count one identifier lookup that searched depth scopes.
+  void countScopeDepth(const int depth)
+  {
+    if ((int) scopeDepths.size() <= depth)
+      scopeDepths.resize(depth + 1, 0);
+    scopeDepths[depth]++;
+  }
+
+  // Add other's counts into this profile.
+  void merge(RULE_PROFILER& other)
+  {
+    if (other.lastRule != NULL)
+      other.lastRule->nanos += now() - other.lastTime;
+    other.lastRule = NULL;
+
+    for (map<pair<const char*, const char*>, RULE_STATS>::iterator itr = other.rules.begin();
+         itr != other.rules.end(); ++itr)
+    {
+      RULE_STATS& stats = rules[itr->first];
+      if (stats.count == 0)
+      {
+        stats.lhs = itr->second.lhs;
+        stats.rhs = itr->second.rhs;
+      }
+      stats.count += itr->second.count;
+      stats.nanos += itr->second.nanos;
+    }
+    if (scopeDepths.size() < other.scopeDepths.size())
+      scopeDepths.resize(other.scopeDepths.size(), 0);
+    for (size_t d = 0; d < other.scopeDepths.size(); d++)
+      scopeDepths[d] += other.scopeDepths[d];
+  }
+
+  // Print the productions, most-reduced first, and the lookup
+  // depth histogram.
+  void report(FILE* out)
+  {
+    if (lastRule != NULL)
+      lastRule->nanos += now() - lastTime;
+    lastRule = NULL;
+
+    // the same production may be reported from more than one
+    // call site, so merge by text
+    map<string, RULE_STATS> merged;
+    for (map<pair<const char*, const char*>, RULE_STATS>::iterator itr = rules.begin();
+         itr != rules.end(); ++itr)
+    {
+      string key = string(itr->second.lhs) + " -> " + itr->second.rhs;
+      RULE_STATS& stats = merged[key];
+      if (stats.count == 0)
+      {
+        stats.lhs = itr->second.lhs;
+        stats.rhs = itr->second.rhs;
+      }
+      stats.count += itr->second.count;
+      stats.nanos += itr->second.nanos;
+    }
+    vector<RULE_STATS> sorted;
+    for (map<string, RULE_STATS>::iterator itr = merged.begin(); itr != merged.end(); ++itr)
+      sorted.push_back(itr->second);
+    stable_sort(sorted.begin(), sorted.end(), byCount);
+
+    fprintf(out, "\n%12s %12s %10s  %s\n", "reductions", "total ms", "avg us", "production");
+    for (size_t i = 0; i < sorted.size(); i++)
+      fprintf(out, "%12lld %12.3f %10.3f  %s -> %s\n", sorted[i].count,
+              sorted[i].nanos / 1e6, sorted[i].nanos / 1e3 / sorted[i].count,
+              sorted[i].lhs, sorted[i].rhs);
+
+    fprintf(out, "\n%12s %12s\n", "scopes", "lookups");
+    for (size_t d = 0; d < scopeDepths.size(); d++)
+      if (scopeDepths[d] > 0)
+        fprintf(out, "%12d %12lld\n", (int) d, scopeDepths[d]);
+  }
+
+};
+
+inline mutex& processRuleProfileLock()
+{
+  static mutex lock;
+  return(lock);
+}
+
+inline void reportRuleProfile();
+
+// The process-wide profile, which each thread's counts are merged
+// into when the thread exits. Function-local statics rather than
+// globals, so that every translation unit that includes this header
+// shares the one profile; the first use registers the atexit()
+// handler that prints it, after the profile is constructed so that
+// it is destroyed only after the handler has run.
+inline RULE_PROFILER& processRuleProfile()
+{
+  static RULE_PROFILER profiler;
+  static int registered = atexit(reportRuleProfile);
+  (void) registered;
+  return(profiler);
+}
+
+// atexit() handler, run when the process exits however the
+// INTERPRETERs were driven: by main() or by a program embedding
+// libminir. Threads still running then are not counted.
+inline void reportRuleProfile()
+{
+  lock_guard<mutex> guard(processRuleProfileLock());
+  processRuleProfile().report(stderr);
+}
+
+// One thread's counts, so that counting takes no lock.
+class THREAD_RULE_PROFILER
+{
+public:
+  RULE_PROFILER profiler;
+
+  THREAD_RULE_PROFILER( ) { processRuleProfile(); }
+
+  ~THREAD_RULE_PROFILER( )
+  {
+    lock_guard<mutex> guard(processRuleProfileLock());
+    processRuleProfile().merge(profiler);
+  }
+};
+
+inline RULE_PROFILER& ruleProfiler()
+{
+  thread_local THREAD_RULE_PROFILER threadProfiler;
+  return(threadProfiler.profiler);
+}
+
+#define PROFILE_RULE(lhs, rhs)      ruleProfiler().countRule(lhs, rhs)
+#define PROFILE_SCOPE_DEPTH(depth)  ruleProfiler().countScopeDepth(depth)
+
+#else
+
+#define PROFILE_RULE(lhs, rhs)
+#define PROFILE_SCOPE_DEPTH(depth)
+
+#endif  // PROFILE_RULES
+
+#endif  // RULE_PROFILER_H
@@ -2,7 +2,7 @@
 #define SYMBOL_TABLE_ENTRY_H
 
 #include <string>
-#include <list>
+#include <vector>
 using namespace std;
 
 // type code declarations
@@ -74,7 +74,7 @@ typedef struct {
   int returnType;   	// return type if function
   bool isParam;		// true if ident is a function param
   TYPE value;
-  list<TYPE>* listValue;
+  vector<TYPE>* listValue;
 } TYPE_INFO;
 
 class SYMBOL_TABLE_ENTRY
@@ -113,11 +113,7 @@ public:
     }
     else
     {
-      typeInfo.listValue = new list<TYPE>;
-      for (list<TYPE>::const_iterator itr = theType.listValue->begin(), end = theType.listValue->end(); itr != end; ++itr) 
-      {
-        typeInfo.listValue->push_back(*itr);
-      }
+      typeInfo.listValue = new vector<TYPE>(*theType.listValue);
     }
   }
 
@@ -0,0 +1,212 @@
+#ifndef TOKEN_CACHE_H
+#define TOKEN_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "MappedFile.h"
+#include "TokenText.h"
+using namespace std;
+
+/*
+  The tokens the scanner produced for a script, saved in a cache
+  directory so the next run of the same script can map them in and
+  skip scanning. The interpreter evaluates as it parses, so tokens
+  are the furthest it can get ahead of a run; there is no tree or
+  code to keep.
+
+  A cache file is named for a hash of the script and of
+  TOKEN_CACHE_VERSION. It holds a TOKEN_CACHE_HEADER, the
+  CACHED_TOKENs, and then the text of the identifiers and strings,
+  back to back. The header repeats the script's hash and length, so
+  a file is only used for the script it was saved for.
+
+  Token codes are assigned by bison in the order of hol.y's %token
+  declarations, so TOKEN_CACHE_VERSION has to change whenever they
+  do, as well as when the layout below does.
+*/
+
+#define TOKEN_CACHE_MAGIC    "MINIRTOK"
+#define TOKEN_CACHE_VERSION  4      // of the layout below and hol.y's token codes
+#define TOKEN_ERROR          -1     // the scanner threw; the text is why
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t tokenSize;       // sizeof(CACHED_TOKEN)
+  uint64_t sourceHash;      // of the script, as hashOf() computes it
+  uint64_t sourceLength;
+  uint64_t numTokens;
+  uint64_t textSize;
+} TOKEN_CACHE_HEADER;
+
+typedef struct {
+  int token;        // as the scanner returned it; 0 at the end,
+                    // TOKEN_ERROR where it threw a MINIR_ERROR
+  int line;         // lineNum once it was scanned
+  int textLength;   // of an IDENT's, STRCONST's or error's text
+  union {
+    int intValue;
+    float floatValue;
+    bool boolValue;
+    uint32_t textOffset;  // of an IDENT's, STRCONST's or error's text
+  } value;
+} CACHED_TOKEN;
+
+class TOKEN_STREAM
+{
+private:
+  MAPPED_FILE file;                 // a loaded stream
+  vector<CACHED_TOKEN> recorded;    // a stream being recorded
+  string recordedText;
+  const CACHED_TOKEN* tokens;
+  size_t numTokens;
+  const char* text;
+  size_t textSize;
+  size_t next;                      // index of the next token to replay
+
+  // not copyable; tokens may point into file
+  TOKEN_STREAM(const TOKEN_STREAM&);
+  TOKEN_STREAM& operator=(const TOKEN_STREAM&);
+
+public:
+  //Constructor
+  TOKEN_STREAM( ) : tokens(NULL), numTokens(0), text(NULL), textSize(0), next(0) { }
+
+  // Return a 64-bit FNV-1a hash of the length bytes of script at
+  // source, and of TOKEN_CACHE_VERSION.
+  static uint64_t hashOf(const char* source, const size_t length)
+  {
+    uint64_t hash = 14695981039346656037ULL;
+    const uint32_t version = TOKEN_CACHE_VERSION;
+    for (size_t i = 0; i < sizeof(version); i++)
+      hash = (hash ^ ((version >> (8 * i)) & 0xff)) * 1099511628211ULL;
+    for (size_t i = 0; i < length; i++)
+      hash = (hash ^ (unsigned char) source[i]) * 1099511628211ULL;
+    return(hash);
+  }
+
+  // Return the cache file name, in directory dir, for the script
+  // whose hash is sourceHash.
+  static string fileNameFor(const string dir, const uint64_t sourceHash)
+  {
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.tok", (unsigned long long) sourceHash);
+    return(dir + "/" + name);
+  }
+
+  // Map in the stream saved in fileName for the script of
+  // sourceLength bytes whose hash is sourceHash.
+  // If it is there and sound, return true; otherwise, return false.
+  bool load(const string fileName, const uint64_t sourceHash, const size_t sourceLength)
+  {
+    if (!file.open(fileName.c_str()))
+      return(false);
+    TOKEN_CACHE_HEADER header;
+    if (file.getSize() < sizeof(header))
+      return(false);
+    memcpy(&header, file.getData(), sizeof(header));
+    if ((memcmp(header.magic, TOKEN_CACHE_MAGIC, sizeof(header.magic)) != 0)
+    || (header.version != TOKEN_CACHE_VERSION)
+    || (header.tokenSize != sizeof(CACHED_TOKEN))
+    || (header.sourceHash != sourceHash)
+    || (header.sourceLength != sourceLength)
+    || (header.numTokens > file.getSize() / sizeof(CACHED_TOKEN))
+    || (sizeof(header) + header.numTokens * sizeof(CACHED_TOKEN) + header.textSize
+        != file.getSize()))
+      return(false);
+
+    tokens = (const CACHED_TOKEN*) (file.getData() + sizeof(header));
+    numTokens = header.numTokens;
+    text = (const char*) (tokens + numTokens);
+    textSize = header.textSize;
+    next = 0;
+    return(true);
+  }
+
+  // Append token, with its text if it is an IDENT, STRCONST or
+  // TOKEN_ERROR, to the stream being recorded.
+  void add(CACHED_TOKEN token, const TOKEN_TEXT* tokenText)
+  {
+    if (tokenText != NULL)
+    {
+      token.value.textOffset = recordedText.size();
+      token.textLength = tokenText->length;
+      recordedText.append(tokenText->start, tokenText->length);
+    }
+    recorded.push_back(token);
+    tokens = recorded.data();
+    numTokens = recorded.size();
+    text = recordedText.data();
+    textSize = recordedText.size();
+  }
+
+  // Write the recorded stream to fileName, for the script of
+  // sourceLength bytes whose hash is sourceHash, by way of a
+  // temporary file of its own (mkstemp()'s, so that no other thread
+  // or process writing the same script shares it) so that a reader
+  // never maps half of one.
+  // If successful, return true; otherwise, return false.
+  bool save(const string fileName, const uint64_t sourceHash, const size_t sourceLength)
+  {
+    TOKEN_CACHE_HEADER header;
+    memcpy(header.magic, TOKEN_CACHE_MAGIC, sizeof(header.magic));
+    header.version = TOKEN_CACHE_VERSION;
+    header.tokenSize = sizeof(CACHED_TOKEN);
+    header.sourceHash = sourceHash;
+    header.sourceLength = sourceLength;
+    header.numTokens = recorded.size();
+    header.textSize = recordedText.size();
+
+    vector<char> tempName(fileName.begin(), fileName.end());
+    const char suffix[] = ".XXXXXX";
+    tempName.insert(tempName.end(), suffix, suffix + sizeof(suffix));
+    int fd = mkstemp(tempName.data());
+    if (fd < 0)
+      return(false);
+    FILE* out = fdopen(fd, "wb");
+    if (out == NULL)
+    {
+      close(fd);
+      unlink(tempName.data());
+      return(false);
+    }
+    bool written = (fwrite(&header, sizeof(header), 1, out) == 1)
+      && (fwrite(recorded.data(), sizeof(CACHED_TOKEN), recorded.size(), out) == recorded.size())
+      && (fwrite(recordedText.data(), 1, recordedText.size(), out) == recordedText.size());
+    if ((fclose(out) != 0) || !written || (rename(tempName.data(), fileName.c_str()) != 0))
+    {
+      unlink(tempName.data());
+      return(false);
+    }
+    return(true);
+  }
+
+  // Return the next token, or NULL past the last one.
+  const CACHED_TOKEN* nextToken()
+  {
+    return((next < numTokens) ? &tokens[next++] : NULL);
+  }
+
+  // Return the text of an IDENT, STRCONST or TOKEN_ERROR token. It
+  // lasts as long as this stream.
+  TOKEN_TEXT textOf(const CACHED_TOKEN* token) const
+  {
+    TOKEN_TEXT result = {"", 0};
+    if ((token->value.textOffset <= textSize)
+    && (token->textLength >= 0)
+    && ((size_t) token->textLength <= textSize - token->value.textOffset))
+    {
+      result.start = text + token->value.textOffset;
+      result.length = token->textLength;
+    }
+    return(result);
+  }
+
+};
+
+#endif  // TOKEN_CACHE_H
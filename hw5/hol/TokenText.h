@@ -0,0 +1,18 @@
+#ifndef TOKEN_TEXT_H
+#define TOKEN_TEXT_H
+
+#include <string>
+using namespace std;
+
+// The text of an IDENT or STRCONST token, as a view into the
+// script's source or a cached token stream rather than a copy.
+// Either one stays in memory for the whole run; the text is not
+// NUL-terminated.
+typedef struct {
+  const char* start;
+  int length;
+
+  string str() const { return(string(start, length)); }
+} TOKEN_TEXT;
+
+#endif  // TOKEN_TEXT_H
@@ -0,0 +1,230 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+/*
+  Structured event tracing for the lexer, parser, scopes and
+  evaluation. The policy is picked at compile time: by default
+  TRACE is TRACER<NO_TRACE>, whose calls are empty and inline
+  away. With -DTRACE_EVENTS it is TRACER<RING_TRACE>, which keeps
+  the newest TRACE_RING_SIZE events in a lock-free ring buffer and
+  writes them at exit as Chrome trace-event JSON (to the file in
+  $MINIR_TRACE_FILE, or minir_trace.json), viewable in
+  chrome://tracing or Perfetto.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <atomic>
+using namespace std;
+
+// event categories
+#define TRACE_LEXER   0
+#define TRACE_PARSER  1
+#define TRACE_SCOPE   2
+#define TRACE_EVAL    3
+
+const int TRACE_RING_SIZE = 1 << 16;  // must be a power of two
+const int TRACE_DETAIL_LENGTH = 32;
+
+typedef struct {
+  long long time;                     // ns since the trace started
+  const char* name;                   // always a string literal
+  char detail[TRACE_DETAIL_LENGTH];   // copied, e.g. a lexeme
+  int thread;                         // the recording thread's id
+  char category;                      // one of the above categories
+  char phase;                         // 'i' instant, 'B' begin, 'E' end
+} TRACE_EVENT;
+
+// A ring slot: an event, and the number of the event it holds plus
+// one (0 while it is being written).
+typedef struct {
+  atomic<unsigned long> sequence;
+  TRACE_EVENT event;
+} TRACE_SLOT;
+
+// Policy that records nothing.
+class NO_TRACE
+{
+public:
+  static void record(const char, const char, const char*, const char*) { }
+};
+
+// Policy that records into a ring buffer. Writers claim a slot with
+// one atomic increment, so recording never takes a lock; once the
+// ring wraps, the oldest events are overwritten. Each slot is a
+// sequence lock: the writer clears its sequence number, fills the
+// event, and then publishes the number with a release store, so the
+// exporter, which may run while other threads still record, skips a
+// slot whose number changed while it was being copied.
+class RING_TRACE
+{
+private:
+  static TRACE_SLOT* ring()
+  {
+    static TRACE_SLOT slots[TRACE_RING_SIZE];
+    return(slots);
+  }
+
+  static atomic<unsigned long>& next()
+  {
+    static atomic<unsigned long> counter(0);
+    return(counter);
+  }
+
+  static long long clockNanos()
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((long long) ts.tv_sec * 1000000000LL + ts.tv_nsec);
+  }
+
+  // Return the time since the trace started. There is one trace per
+  // process, so every interpreter's events share this start and line
+  // up in the export; the static is initialized once, thread-safely.
+  static long long now()
+  {
+    static const long long startTime = clockNanos();
+    return(clockNanos() - startTime);
+  }
+
+  // Return the kernel's id for the calling thread, as perf and
+  // Perfetto show it; looked up once per thread.
+  static int threadId()
+  {
+    static thread_local const int id = (int) syscall(SYS_gettid);
+    return(id);
+  }
+
+  // Start the clock, and export the ring when the process exits (as
+  // the rule profile is printed; see reportRuleProfile()). Called by
+  // every record(), but the static is initialized only by the first,
+  // so tracing needs no setup from main() or an embedding program.
+  static void start()
+  {
+    static const int registered = (now(), atexit(dump));
+    (void) registered;
+  }
+
+  // Copy the event numbered i into e, if its slot still holds it
+  // unchanged.
+  // If successful, return true; otherwise, return false.
+  static bool readEvent(const unsigned long i, TRACE_EVENT& e)
+  {
+    TRACE_SLOT& slot = ring()[i & (TRACE_RING_SIZE - 1)];
+    if (slot.sequence.load(memory_order_acquire) != i + 1)
+      return(false);
+    e = slot.event;
+    atomic_thread_fence(memory_order_acquire);
+    return(slot.sequence.load(memory_order_relaxed) == i + 1);
+  }
+
+  // Write text to out as the body of a JSON string.
+  static void writeEscaped(FILE* out, const char* text)
+  {
+    for (; *text != '\0'; text++)
+    {
+      unsigned char c = *text;
+      if ((c == '"') || (c == '\\'))
+        fprintf(out, "\\%c", c);
+      else if (c < 0x20)
+        fprintf(out, "\\u%04x", c);
+      else
+        fputc(c, out);
+    }
+  }
+
+  static void dump()
+  {
+    const char* fileName = getenv("MINIR_TRACE_FILE");
+    FILE* out = fopen((fileName != NULL) ? fileName : "minir_trace.json", "w");
+    if (out == NULL)
+      return;
+
+    static const char* categories[] = {"lexer", "parser", "scope", "eval"};
+    unsigned long last = next().load();
+    unsigned long first = (last > (unsigned long) TRACE_RING_SIZE) ? last - TRACE_RING_SIZE : 0;
+    int pid = getpid();
+
+    fprintf(out, "{\"traceEvents\":[\n");
+    bool isFirst = true;
+    for (unsigned long i = first; i < last; i++)
+    {
+      // skip events still being written, or overwritten since
+      TRACE_EVENT e;
+      if (!readEvent(i, e))
+        continue;
+      fprintf(out, "%s{\"name\":\"", isFirst ? "" : ",\n");
+      isFirst = false;
+      writeEscaped(out, e.name);
+      fprintf(out, "\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+              categories[(int) e.category], e.phase, e.time / 1000.0, pid, e.thread);
+      if (e.phase == 'i')
+        fprintf(out, ",\"s\":\"t\"");
+      if (e.detail[0] != '\0')
+      {
+        fprintf(out, ",\"args\":{\"detail\":\"");
+        writeEscaped(out, e.detail);
+        fprintf(out, "\"}");
+      }
+      fprintf(out, "}");
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+  }
+
+public:
+  static void record(const char category, const char phase,
+                     const char* name, const char* detail)
+  {
+    start();
+    unsigned long i = next().fetch_add(1, memory_order_relaxed);
+    TRACE_SLOT& slot = ring()[i & (TRACE_RING_SIZE - 1)];
+    slot.sequence.store(0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    TRACE_EVENT& e = slot.event;
+    e.time = now();
+    e.thread = threadId();
+    e.name = name;
+    e.category = category;
+    e.phase = phase;
+    strncpy(e.detail, (detail != NULL) ? detail : "", TRACE_DETAIL_LENGTH - 1);
+    e.detail[TRACE_DETAIL_LENGTH - 1] = '\0';
+    slot.sequence.store(i + 1, memory_order_release);
+  }
+};
+
+// The events the interpreter reports, recorded through POLICY.
+template <class POLICY>
+class TRACER
+{
+public:
+  static void token(const char* tokenType, const char* lexeme)
+  {
+    POLICY::record(TRACE_LEXER, 'i', tokenType, lexeme);
+  }
+
+  static void rule(const char* lhs, const char* rhs)
+  {
+    POLICY::record(TRACE_PARSER, 'i', lhs, rhs);
+  }
+
+  static void beginScope() { POLICY::record(TRACE_SCOPE, 'B', "scope", NULL); }
+  static void endScope() { POLICY::record(TRACE_SCOPE, 'E', "scope", NULL); }
+
+  static void eval(const char* what, const char* detail)
+  {
+    POLICY::record(TRACE_EVAL, 'i', what, detail);
+  }
+};
+
+#ifdef TRACE_EVENTS
+typedef TRACER<RING_TRACE> TRACE;
+#else
+typedef TRACER<NO_TRACE> TRACE;
+#endif
+
+#endif  // TRACER_H
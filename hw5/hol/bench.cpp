@@ -0,0 +1,351 @@
+/*
+    bench.cpp
+
+    Microbenchmarks for the lexer, parser, symbol table and lists.
+    The lexer runs once with flex and once with each width of
+    FastScanner.h, for an A/B comparison, and over a script of
+    nothing but numbers with flex and with FAST_SCANNER. It also
+    reports the size of the flex DFA, and times telling keywords
+    from identifiers by the perfect hash in Keywords.h against
+    comparing with each keyword in turn.
+
+    flex hol.l
+    bison hol.y
+    g++ -O2 -pthread bench.cpp -o bench -lrt
+    ./bench [cpu]
+
+    Every benchmark takes WARMUP_SAMPLES untimed samples and then
+    SAMPLES timed ones (fewer, down to MIN_SAMPLES, if the samples
+    are slow), and reports the median and 99th percentile
+    time per operation. The process is pinned to one CPU (0 unless
+    given on the command line) to keep the samples comparable.
+*/
+
+#define MINIR_NO_MAIN
+#include "hol.tab.c"
+#include <sched.h>
+#include <vector>
+#include <string>
+#include <algorithm>
+using namespace std;
+
+const int WARMUP_SAMPLES = 20;
+const int SAMPLES = 200;
+const int MIN_SAMPLES = 25;
+const double SECONDS_PER_BENCHMARK = 2.0;  // slow samples are taken fewer times
+
+FILE* report;   // the real stdout; stdout itself goes to /dev/null
+INTERPRETER interpreter;
+yyscan_t scanner;
+
+long long nowNanos()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return((long long) ts.tv_sec * 1000000000LL + ts.tv_nsec);
+}
+
+// Time SAMPLES calls of sample(), each of which performs opsPerSample
+// operations, and print the median and p99 ns per operation. If
+// unitsPerOp is nonzero, also print a throughput in unitName/s.
+template <class SAMPLE>
+void runBenchmark(const string name, const string param, SAMPLE sample,
+                  const int opsPerSample, const double unitsPerOp = 0,
+                  const char* unitName = "")
+{
+    long long start = nowNanos();
+    sample();
+    double sampleSeconds = (nowNanos() - start) / 1e9;
+    int numSamples = SAMPLES;
+    if (sampleSeconds * (WARMUP_SAMPLES + SAMPLES) > SECONDS_PER_BENCHMARK)
+        numSamples = max(MIN_SAMPLES, (int) (SECONDS_PER_BENCHMARK / sampleSeconds) - WARMUP_SAMPLES);
+    int numWarmups = (numSamples == SAMPLES) ? WARMUP_SAMPLES : numSamples / 10;
+    for (int i = 1; i < numWarmups; i++)
+        sample();
+
+    vector<double> times;
+    for (int i = 0; i < numSamples; i++)
+    {
+        long long start = nowNanos();
+        sample();
+        times.push_back((double) (nowNanos() - start) / opsPerSample);
+    }
+    sort(times.begin(), times.end());
+    double median = times[times.size() / 2];
+    double p99 = times[(times.size() * 99) / 100];
+
+    fprintf(report, "%-28s %-14s %12.1f %12.1f", name.c_str(), param.c_str(), median, p99);
+    if (unitsPerOp > 0)
+        fprintf(report, "   %10.2f %s/s", unitsPerOp / median * 1e9, unitName);
+    fprintf(report, "\n");
+    fflush(report);
+}
+
+// Return text as a flex buffer, which needs two trailing NULs.
+vector<char> makeScanBuffer(const string text)
+{
+    vector<char> buffer(text.begin(), text.end());
+    buffer.push_back('\0');
+    buffer.push_back('\0');
+    return(buffer);
+}
+
+// Run the lexer of the given SCANNER_ kind over all of buffer.
+void scanAll(vector<char>& buffer, const int kind)
+{
+    YY_BUFFER_STATE state = yy_scan_buffer(&buffer[0], buffer.size(), scanner);
+    FAST_SCANNER fast(&buffer[0], buffer.size() - 2, interpreter.lineNum, kind);
+    interpreter.fastScanner = (kind != SCANNER_FLEX) ? &fast : NULL;
+    YYSTYPE value;
+    while (yylex(&value, scanner) != 0)
+        ;
+    interpreter.fastScanner = NULL;
+    yy_delete_buffer(state, scanner);
+}
+
+// Parse and evaluate the one expression in buffer.
+void parseOne(vector<char>& buffer)
+{
+    YY_BUFFER_STATE state = yy_scan_buffer(&buffer[0], buffer.size(), scanner);
+    yyparse(interpreter, scanner);
+    yy_delete_buffer(state, scanner);
+}
+
+// Return a list(...) literal of length n.
+string makeListLiteral(const int n)
+{
+    string text = "list(";
+    for (int i = 1; i <= n; i++)
+        text += to_string(i) + ((i < n) ? ", " : ")");
+    return(text);
+}
+
+void benchLexer()
+{
+    const string snippet =
+        "{ x1 = list(1, 2.5, TRUE, \"BoJack\"); # comment\n"
+        "  y = (x1[[1]] + 42) * 3.14 / 7 - 1 %% 2 ^ 2;\n"
+        "  if ((y >= 3) & !FALSE | (y != 2)) print(y) else cat(\"no\")\n"
+        "}\n";
+    string text;
+    while (text.size() < (1 << 20))
+        text += snippet;
+    vector<char> buffer = makeScanBuffer(text);
+
+    // flex against FastScanner.h, A/B
+    const int kinds[] = {SCANNER_FLEX, SCANNER_SSE2, SCANNER_AVX2};
+    const char* params[] = {"1 MB flex", "1 MB sse2", "1 MB avx2"};
+    for (int i = 0; i < 3; i++)
+    {
+        if ((kinds[i] == SCANNER_AVX2) && !__builtin_cpu_supports("avx2"))
+            continue;
+        runBenchmark("lexer", params[i], [&]() { scanAll(buffer, kinds[i]); },
+                     1, text.size() / 1e6, "MB");
+    }
+
+    // numbers, as in the data of a generated script
+    string numbers = "list(";
+    for (int i = 0; numbers.size() < (1 << 20); i++)
+        numbers += to_string(i * 7919 % 100000) + ", " + to_string(i % 1000) + "."
+                   + to_string(i * 31 % 1000) + ", ";
+    numbers += "0)";
+    vector<char> numberBuffer = makeScanBuffer(numbers);
+    runBenchmark("lexer", "1 MB numbers", [&]() { scanAll(numberBuffer, SCANNER_FLEX); },
+                 1, numbers.size() / 1e6, "MB");
+    runBenchmark("lexer", "1 MB num fast", [&]() { scanAll(numberBuffer, SCANNER_FAST); },
+                 1, numbers.size() / 1e6, "MB");
+}
+
+// Return the keyword text is by comparing it with each in turn,
+// the way the scanner did with a rule per keyword.
+const KEYWORD* findKeywordLinear(const char* text, const int length)
+{
+    for (int i = 0; i < NUM_KEYWORDS; i++)
+        if ((strncmp(KEYWORDS[i].text, text, length) == 0) && (KEYWORDS[i].text[length] == '\0'))
+            return(&KEYWORDS[i]);
+    return(NULL);
+}
+
+void benchKeywords()
+{
+    // the tables flex compiled hol.l to; every state is a row of
+    // yy_base/yy_def and a slice of yy_nxt/yy_chk
+    int numStates = sizeof(yy_accept) / sizeof(yy_accept[0]) - 1;
+    int numTransitions = sizeof(yy_nxt) / sizeof(yy_nxt[0]);
+    int tableBytes = sizeof(yy_accept) + sizeof(yy_ec) + sizeof(yy_meta) + sizeof(yy_base)
+                     + sizeof(yy_def) + sizeof(yy_nxt) + sizeof(yy_chk);
+    fprintf(report, "%-28s %-14s %12d states, %d transitions, %d bytes\n",
+            "flex DFA", "", numStates, numTransitions, tableBytes);
+
+    // identifiers as they come in scripts: mostly keywords and short
+    // names, some that start like a keyword
+    const char* words[] = {"x1", "list", "TRUE", "y", "if", "print", "else", "cat",
+                           "i", "for", "in", "total", "readLines", "reader", "FALSE", "n"};
+    const int numWords = sizeof(words) / sizeof(words[0]);
+    int lengths[numWords];
+    for (int i = 0; i < numWords; i++)
+        lengths[i] = strlen(words[i]);
+    volatile int found = 0;
+    runBenchmark("keyword lookup", "perfect hash", [&]() {
+        for (int j = 0; j < 100; j++)
+            for (int i = 0; i < numWords; i++)
+                found += (findKeyword(words[i], lengths[i]) != NULL);
+    }, 100 * numWords);
+    runBenchmark("keyword lookup", "linear", [&]() {
+        for (int j = 0; j < 100; j++)
+            for (int i = 0; i < numWords; i++)
+                found += (findKeywordLinear(words[i], lengths[i]) != NULL);
+    }, 100 * numWords);
+}
+
+void benchParser()
+{
+    const char* exprs[][2] = {
+        {"arith", "1 + 2 * 3 - 4 / 2 + 5 %% 3 - 2 ^ 3"},
+        {"logic", "(1 < 2) & !FALSE | (3 > 4)"},
+        {"compound", "{ a = 1; b = a + 2; print(b); a * b }"},
+        {"if", "if (TRUE) 1 + 2 else 3"},
+        {"list", "list(1, 2.5, TRUE, \"s\", 5, 6, 7, 8)"},
+    };
+    for (size_t i = 0; i < sizeof(exprs) / sizeof(exprs[0]); i++)
+    {
+        vector<char> text = makeScanBuffer(exprs[i][1]);
+        runBenchmark("parser", exprs[i][0], [&]() {
+            for (int j = 0; j < 100; j++)
+            {
+                vector<char> buffer = text;
+                parseOne(buffer);
+            }
+        }, 100, 1, "expr");
+    }
+}
+
+void benchSymbolTable()
+{
+    const int sizes[] = {10, 1000, 100000};
+    TYPE_INFO info = {INT, NOT_APPLICABLE, NOT_APPLICABLE, false};
+    info.listValue = NULL;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++)
+    {
+        int n = sizes[s];
+        vector<string> names;
+        for (int i = 0; i < n; i++)
+            names.push_back("v" + to_string(i * 7919 % n));
+        string param = "size " + to_string(n);
+        int samples = (n > 1000) ? 1 : 1000 / n;
+
+        runBenchmark("SYMBOL_TABLE::addEntry", param, [&]() {
+            for (int k = 0; k < samples; k++)
+            {
+                SYMBOL_TABLE table;
+                for (int i = 0; i < n; i++)
+                    table.addEntry(SYMBOL_TABLE_ENTRY(names[i], info));
+            }
+        }, n * samples);
+
+        SYMBOL_TABLE table;
+        for (int i = 0; i < n; i++)
+            table.addEntry(SYMBOL_TABLE_ENTRY(names[i], info));
+        int lookups = 1000;
+        runBenchmark("SYMBOL_TABLE::findEntry", param, [&]() {
+            for (int i = 0; i < lookups; i++)
+                table.findEntry(names[(i * 31) % n]);
+        }, lookups);
+        runBenchmark("SYMBOL_TABLE::changeEntry", param, [&]() {
+            for (int i = 0; i < lookups; i++)
+                table.changeEntry(SYMBOL_TABLE_ENTRY(names[(i * 31) % n], info));
+        }, lookups);
+    }
+}
+
+void benchScopes()
+{
+    const int depths[] = {1, 4, 16, 64};
+    TYPE_INFO info = {INT, NOT_APPLICABLE, NOT_APPLICABLE, false};
+    info.listValue = NULL;
+    // a global scope with a few dozen names, like a real script
+    for (int i = 0; i < 32; i++)
+        interpreter.scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY("g" + to_string(i), info));
+
+    for (size_t d = 0; d < sizeof(depths) / sizeof(depths[0]); d++)
+    {
+        for (int i = 1; i < depths[d]; i++)
+        {
+            interpreter.beginScope();
+            interpreter.scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY("p", info));
+        }
+        runBenchmark("findEntryInAnyScope", "depth " + to_string(depths[d]), [&]() {
+            for (int i = 0; i < 100; i++)
+                interpreter.findEntryInAnyScope("g17");
+        }, 100);
+        for (int i = 1; i < depths[d]; i++)
+            interpreter.endScope();
+    }
+}
+
+void benchLists()
+{
+    const int lengths[] = {10, 100, 1000, 100000};
+    for (size_t l = 0; l < sizeof(lengths) / sizeof(lengths[0]); l++)
+    {
+        int n = lengths[l];
+        string param = "length " + to_string(n);
+        int reps = (n >= 1000) ? 1 : 10;
+
+        // building a list from a literal is the only way to grow one
+        vector<char> build = makeScanBuffer("x = " + makeListLiteral(n));
+        runBenchmark("list build", param, [&]() {
+            for (int j = 0; j < reps; j++)
+            {
+                vector<char> buffer = build;
+                parseOne(buffer);
+            }
+        }, reps * n, 1, "elem");
+
+        vector<char> index = makeScanBuffer("x[[" + to_string(n) + "]]");
+        runBenchmark("list index", param, [&]() {
+            for (int j = 0; j < 100; j++)
+            {
+                vector<char> buffer = index;
+                parseOne(buffer);
+            }
+        }, 100);
+
+        // print() of a variable doesn't see the variable's list
+        // yet, so this prints a literal and includes building it
+        vector<char> print = makeScanBuffer("print(" + makeListLiteral(n) + ")");
+        runBenchmark("list build+print", param, [&]() {
+            for (int j = 0; j < reps; j++)
+            {
+                vector<char> buffer = print;
+                parseOne(buffer);
+            }
+        }, reps * n, 1, "elem");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int cpu = (argc > 1) ? atoi(argv[1]) : 0;
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0)
+        fprintf(stderr, "warning: could not pin to CPU %d\n", cpu);
+
+    // keep the results; the interpreter's own output is discarded
+    report = fdopen(dup(fileno(stdout)), "w");
+    if (freopen("/dev/null", "w", stdout) == NULL)
+        return 1;
+
+    fprintf(report, "%-28s %-14s %12s %12s\n", "benchmark", "", "median ns", "p99 ns");
+    yylex_init_extra(&interpreter, &scanner);
+    interpreter.beginScope();
+    benchLexer();
+    benchKeywords();
+    benchParser();
+    benchSymbolTable();
+    benchScopes();
+    benchLists();
+    return 0;
+}
@@ -0,0 +1,293 @@
+/*
+    conform.cpp
+
+    Conformance runner. Runs the interpreter on every file in an
+    input directory, several at a time, and compares each output
+    with the expected one the way hw5_reports.sh does with diff
+    (--ignore-space-change --ignore-case --ignore-blank-lines),
+    writing the actual output and a side-by-side report per input.
+
+    flex hol.l
+    bison hol.y
+    g++ -O2 -pthread conform.cpp -o conform -lrt
+    ./conform [-j jobs] [-t seconds] sample_input expected_output \
+              actual_output reports
+
+    Each input runs in this process on one of jobs worker threads
+    (default: one per CPU), in an INTERPRETER of its own whose output
+    handler collects what it prints and whose read() sees end of
+    input, as with < /dev/null; nothing is forked, exec'd or
+    recompiled per input. A thread cannot be stopped partway, so the
+    time limit (default 10 s) is checked when an input finishes, and
+    one that ran longer fails. Results are listed in input order.
+    Exits with 1 if any input's output differs.
+*/
+
+#define MINIR_NO_MAIN
+#include "hol.tab.c"
+#include <ctype.h>
+#include <dirent.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+const int REPORT_COLUMN_WIDTH = 61;    // as diff --side-by-side
+
+typedef struct {
+    vector<string> text;        // as read
+    vector<string> normalized;  // as compared
+} OUTPUT_LINES;
+
+// What running one input came to.
+typedef struct {
+    bool passed;
+    const char* problem;        // why it failed, besides differing; or NULL
+} RESULT;
+
+// Return the time on the monotonic clock, in seconds.
+double secondsNow()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return(ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+// Run the interpreter on inputFile the way main() does, writing what
+// it prints to outputFile.
+// If it finished within seconds, return true; otherwise, return false.
+bool interpret(const string inputFile, const string outputFile, const int seconds)
+{
+    string output;
+    double start = secondsNow();
+    if (access(inputFile.c_str(), R_OK) != 0)
+        output = "Cannot open " + inputFile + "\n";
+    else
+    {
+        INTERPRETER interpreter;
+        interpreter.setOutputHandler(
+            [&](const char* text, size_t length) { output.append(text, length); });
+        interpreter.setInputHandler([](string&) { return(false); });
+        interpreter.scannerKind = scannerKindOf(getenv("MINIR_SCANNER"));
+        interpreter.runFile(inputFile);
+    }
+    bool inTime = (secondsNow() - start <= seconds);
+
+    FILE* out = fopen(outputFile.c_str(), "w");
+    if (out != NULL)
+    {
+        fwrite(output.data(), 1, output.size(), out);
+        fclose(out);
+    }
+    return(inTime);
+}
+
+// Return line as diff -b -i compares it: lowercase, with every run of
+// white space one blank and none at the end.
+string normalize(const string line)
+{
+    string result;
+    for (size_t i = 0; i < line.size(); i++)
+    {
+        if (isspace((unsigned char) line[i]))
+        {
+            if ((i == 0) || !isspace((unsigned char) line[i - 1]))
+                result += ' ';
+        }
+        else
+            result += tolower((unsigned char) line[i]);
+    }
+    if ((result.size() > 0) && (result[result.size() - 1] == ' '))
+        result.erase(result.size() - 1);
+    return(result);
+}
+
+// Read the nonblank lines of fileName.
+// If successful, return true; otherwise, return false.
+bool readOutput(const string fileName, OUTPUT_LINES& lines)
+{
+    FILE* in = fopen(fileName.c_str(), "r");
+    if (in == NULL)
+        return(false);
+    string line;
+    int c;
+    do
+    {
+        c = getc(in);
+        if ((c != '\n') && (c != EOF))
+            line += (char) c;
+        else
+        {
+            string n = normalize(line);
+            if (n.size() > 0)
+            {
+                lines.text.push_back(line);
+                lines.normalized.push_back(n);
+            }
+            line.clear();
+        }
+    } while (c != EOF);
+    fclose(in);
+    return(true);
+}
+
+// Write one line of a side-by-side report.
+void writeReportLine(FILE* out, const string left, const char gutter, const string right)
+{
+    fprintf(out, "%-*.*s %c %s\n", REPORT_COLUMN_WIDTH, REPORT_COLUMN_WIDTH,
+            left.c_str(), gutter, right.c_str());
+}
+
+// Compare actual with expected by longest common subsequence, and
+// write them side by side to reportFile, marking lines that changed
+// with |, lines only in actual with < and lines only in expected
+// with >.
+// If they match, return true; otherwise, return false.
+bool compareOutputs(const OUTPUT_LINES& actual, const OUTPUT_LINES& expected,
+                    const string reportFile)
+{
+    size_t n = actual.normalized.size();
+    size_t m = expected.normalized.size();
+    // common[i][j] = LCS length of actual[i..] and expected[j..]
+    vector<vector<int> > common(n + 1, vector<int>(m + 1, 0));
+    for (size_t i = n; i-- > 0; )
+        for (size_t j = m; j-- > 0; )
+            common[i][j] = (actual.normalized[i] == expected.normalized[j])
+                           ? common[i + 1][j + 1] + 1
+                           : max(common[i + 1][j], common[i][j + 1]);
+
+    FILE* out = fopen(reportFile.c_str(), "w");
+    bool same = (common[0][0] == (int) n) && (n == m);
+    size_t i = 0, j = 0;
+    while ((i < n) || (j < m))
+    {
+        if ((i < n) && (j < m) && (actual.normalized[i] == expected.normalized[j]))
+        {
+            if (out != NULL)
+                writeReportLine(out, actual.text[i], ' ', expected.text[j]);
+            i++;
+            j++;
+        }
+        else if ((i < n) && (j < m) && (common[i + 1][j] == common[i][j + 1]))
+        {
+            if (out != NULL)
+                writeReportLine(out, actual.text[i], '|', expected.text[j]);
+            i++;
+            j++;
+        }
+        else if ((i < n) && ((j == m) || (common[i + 1][j] >= common[i][j + 1])))
+        {
+            if (out != NULL)
+                writeReportLine(out, actual.text[i], '<', "");
+            i++;
+        }
+        else
+        {
+            if (out != NULL)
+                writeReportLine(out, "", '>', expected.text[j]);
+            j++;
+        }
+    }
+    if (out != NULL)
+        fclose(out);
+    return(same);
+}
+
+// Return the names of the files in dirName, sorted.
+vector<string> listInputs(const string dirName)
+{
+    vector<string> names;
+    DIR* dir = opendir(dirName.c_str());
+    if (dir == NULL)
+        return(names);
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        string name = entry->d_name;
+        // skip dot files and editor backups, as ls --ignore-backups does
+        if ((name[0] != '.') && (name[name.size() - 1] != '~'))
+            names.push_back(name);
+    }
+    closedir(dir);
+    sort(names.begin(), names.end());
+    return(names);
+}
+
+int main(int argc, char** argv)
+{
+    int numJobs = sysconf(_SC_NPROCESSORS_ONLN);
+    int seconds = 10;
+    int arg = 1;
+    for (; (arg + 1 < argc) && (argv[arg][0] == '-'); arg += 2)
+    {
+        if (strcmp(argv[arg], "-j") == 0)
+            numJobs = atoi(argv[arg + 1]);
+        else if (strcmp(argv[arg], "-t") == 0)
+            seconds = atoi(argv[arg + 1]);
+        else
+            break;
+    }
+    if ((argc - arg != 4) || (numJobs < 1) || (seconds < 1))
+    {
+        fprintf(stderr, "usage: %s [-j jobs] [-t seconds] input_dir expected_dir"
+                        " actual_dir report_dir\n", argv[0]);
+        return 2;
+    }
+    string inputDir = argv[arg];
+    string expectedDir = argv[arg + 1];
+    string actualDir = argv[arg + 2];
+    string reportDir = argv[arg + 3];
+
+    vector<string> inputs = listInputs(inputDir);
+    if (inputs.empty())
+    {
+        fprintf(stderr, "no inputs in %s\n", inputDir.c_str());
+        return 2;
+    }
+
+    // each worker takes the next input until there are none left
+    vector<RESULT> results(inputs.size());
+    atomic<size_t> next(0);
+    auto work = [&]()
+    {
+        for (size_t i = next++; i < inputs.size(); i = next++)
+        {
+            const string& name = inputs[i];
+            RESULT& result = results[i];
+            result.problem = NULL;
+            if (!interpret(inputDir + "/" + name, actualDir + "/" + name + ".out", seconds))
+                result.problem = "timed out";
+
+            OUTPUT_LINES actual, expected;
+            readOutput(actualDir + "/" + name + ".out", actual);
+            if (!readOutput(expectedDir + "/" + name + ".out", expected) && (result.problem == NULL))
+                result.problem = "no expected output";
+            bool same = compareOutputs(actual, expected, reportDir + "/" + name);
+            result.passed = same && (result.problem == NULL);
+        }
+    };
+    vector<thread> workers;
+    for (int j = 0; j < numJobs; j++)
+        workers.push_back(thread(work));
+    for (size_t j = 0; j < workers.size(); j++)
+        workers[j].join();
+
+    int numFailed = 0;
+    for (size_t i = 0; i < inputs.size(); i++)
+    {
+        if (!results[i].passed)
+        {
+            numFailed++;
+            printf("FAIL  %s%s%s\n", inputs[i].c_str(), (results[i].problem != NULL) ? ": " : "",
+                   (results[i].problem != NULL) ? results[i].problem : "");
+        }
+        else
+            printf("ok    %s\n", inputs[i].c_str());
+    }
+    printf("\n%d of %d inputs passed\n", (int) inputs.size() - numFailed, (int) inputs.size());
+    return (numFailed > 0) ? 1 : 0;
+}
@@ -3,8 +3,14 @@
 
     flex minir.l
     bison minir.y
-    g++ minir.tab.c -o parser
+    g++ -pthread minir.tab.c -o parser -lrt
+    (add -DPROFILE_RULES to print reduction counts to stderr at exit,
+     and -DTRACE_EVENTS to write a Chrome trace of the run)
+    (set MINIR_CACHE_DIR to keep scanned scripts there; see TokenCache.h,
+     and MINIR_SCANNER=flex to scan with hol.l's scanner instead of
+     FastScanner.h)
     ./parser < inputFileName
+    (or compile with -DMINIR_NO_MAIN into libminir; see minir.h)
     
 */
 
@@ -17,7 +23,15 @@
 #include <stack>
 #include <iomanip> 
 #include <cmath>
+#include <algorithm>
 #include "SymbolTable.h"
+#include "Interpreter.h"
+#include "ListReader.h"
+#include "CsvReader.h"
+#include "ListStore.h"
+#include "RuleProfiler.h"
+#include "Tracer.h"
+#include "TokenText.h"
 using namespace std;
 
 #define ARITHMETIC_OP   1
@@ -60,8 +74,15 @@ using namespace std;
 #define ERR_ERROR						14
 #define ERR_SUB_OUT_OF_BOUNDS   15
 #define ERR_ATTEMPTED_DIV_BY_ZERO   16
+#define ERR_MUST_BE_STR     17
+#define ERR_CANNOT_OPEN_FILE    18
+#define ERR_MUST_BE_INT_OR_STR  19
+#define ERR_BAD_DATA_FILE   20
+#define ERR_NUMBER_OUT_OF_RANGE 21
+#define ERR_MISSING_VALUE       22
+#define ERR_STRING_TOO_LONG     23
 
-const int NUM_ERR_MESSAGES = 17;  // should be ERR_ERROR + 1
+const int NUM_ERR_MESSAGES = 24;  // should be ERR_ERROR + 1
 
 const string ERR_MSG[NUM_ERR_MESSAGES] = {
 "cannot be function or null or list or string",
@@ -80,17 +101,19 @@ const string ERR_MSG[NUM_ERR_MESSAGES] = {
 "Undefined identifier",
 "<undefined error>",
 "Subscript out of bounds",
-"Attempted division by zero"
+"Attempted division by zero",
+"must be string",
+"Cannot open file",
+"must be integer or string",
+"Not a MiniR data file",
+NUMBER_RANGE_MESSAGE,
+"Empty field in integer or float or bool column",
+"String longer than 255 characters"
 };
 
 // constant to suppress token printing
 const bool suppressTokenOutput = true;
 
-int line_num = 1;
-int numExprs = 0;
-
-stack<SYMBOL_TABLE> scopeStack; // stack of scope hashtables
-
 bool isIntOrFloatOrBoolCompatible(const int theType);
 bool isIntCompatible(const int theType);
 bool isBoolCompatible(const int theType);
@@ -98,35 +121,32 @@ bool isFloatCompatible(const int theType);
 bool isListCompatible(const int theType);
 bool isInvalidOperandType(const int theType);
 
-void beginScope();
-void endScope();
-void cleanUp();
-TYPE_INFO findEntryInAnyScope(const string the_name);
+int scalarTypeOf(const TYPE_INFO& x);
+void applyBinaryOp(INTERPRETER& interpreter, const int op, const TYPE_INFO& left,
+                   const TYPE_INFO& right, TYPE_INFO& result);
+
+#include "Operators.h"
 
-void semanticError(const int argNum, const int errNum);
+string unquote(const char* text);
 
 void printTokenInfo(const char* token_type, const char* lexeme);
 
 void printRule(const char *, const char *);
 
-int yyerror(const char *s) 
+// Report a syntax error; INTERPRETER::run() catches it.
+int yyerror(INTERPRETER& interpreter, void* /* scanner */, const char *s) 
 {
-    printf("Line %d: %s\n", line_num, s);
-    cleanUp();
-    exit(1);
-}
-
-extern "C" 
-{
-    int yyparse(void);
-    int yylex(void);
-    int yywrap() { return 1; }
+    throw MINIR_ERROR(interpreter.lineNum, s);
 }
 
 %}
 
+%define api.pure full
+%parse-param {INTERPRETER& interpreter} {void* scanner}
+%lex-param {void* scanner}
+
 %union {
-    char* text;
+    TOKEN_TEXT text;
     int num;
     int intValue;
     float floatValue;
@@ -135,6 +155,7 @@ extern "C"
     TYPE_INFO typeInfo;
 };
 
+// changing these changes the token codes; bump TOKEN_CACHE_VERSION
 %token T_IDENT T_INTCONST T_FLOATCONST T_UNKNOWN T_STRCONST 
 %token T_IF T_ELSE
 %token T_WHILE T_FUNCTION T_FOR T_IN T_NEXT T_BREAK 
@@ -145,6 +166,17 @@ extern "C"
 %token T_MULT T_DIV T_MOD
 %token T_POW T_LT T_LE T_GT T_GE T_EQ T_NE T_NOT T_AND 
 %token T_OR T_ASSIGN T_LIST
+%token T_SCAN T_READLINES T_READCSV
+%token T_SAVERDS T_READRDS
+
+%code {
+    // the reentrant scanner in lex.yy.c
+    int scanToken(YYSTYPE* yylval_param, void* yyscanner);
+    // the next token: scanToken()'s, or a cached one
+    int nextToken(YYSTYPE* yylval_param, void* yyscanner);
+    // the parser's tokens: nextToken()'s
+    int yylex(YYSTYPE* yylval_param, void* yyscanner);
+}
 
 %type <text> T_IDENT T_STRCONST
 
@@ -154,8 +186,8 @@ extern "C"
 %type <typeInfo> N_INPUT_EXPR N_OUTPUT_EXPR N_LIST_EXPR
 %type <typeInfo> N_FUNCTION_DEF N_FUNCTION_CALL
 %type <typeInfo> N_QUIT_EXPR N_CONST N_EXPR_LIST
-%type <typeInfo> N_SIMPLE_ARITHLOGIC N_TERM N_ADD_OP_LIST
-%type <typeInfo> N_FACTOR N_MULT_OP_LIST N_VAR N_CONST_LIST
+%type <typeInfo> N_SIMPLE_ARITHLOGIC N_TERM
+%type <typeInfo> N_FACTOR N_VAR N_CONST_LIST
 %type <typeInfo> N_SINGLE_ELEMENT N_ENTIRE_VAR N_INDEX
 
 
@@ -180,8 +212,12 @@ extern "C"
 N_START:        N_EXPR
                 {
                     printRule("START", "EXPR");
-                    printf("\n---- Completed parsing ----\n\n");
-                    printf("Value of the expression is: ");
+                    TRACE::eval("expression complete", NULL);
+                    interpreter.result = $1;
+                    if(!interpreter.printResults)
+                        return 0;
+                    interpreter.output << "\n---- Completed parsing ----\n\n";
+                    interpreter.output << "Value of the expression is: ";
                     
                     
                     //cout << "\nN_START = " << $1.value.intValue << endl;
@@ -195,63 +231,63 @@ N_START:        N_EXPR
                     switch($1.type)
                     {
                         case NULL_TYPE:
-                            cout << "NULL" << endl;
+                            interpreter.output << "NULL" << endl;
                             break;
                         case INT:
-                            cout << $1.value.intValue;
+                            interpreter.output << $1.value.intValue;
                             //cout <<"$$$inside int =" <<endl; ;
                             break;
                         case STR:
-                            cout << $1.value.stringValue;
+                            interpreter.output << $1.value.stringValue;
                             break;
                         case BOOL:
                             if($1.value.boolValue)
                             {
-                                cout << "TRUE";   
+                                interpreter.output << "TRUE";   
                             }
                             else
                             {
-                                cout << "FALSE";
+                                interpreter.output << "FALSE";
                             }
                             break;
                         case FLOAT:
-                            cout << fixed << setprecision(2) << $1.value.floatValue; 
+                            interpreter.output << fixed << setprecision(2) << $1.value.floatValue; 
                             break;
                         case LIST:
-                            cout << "( ";
-                            for (list<TYPE>::const_iterator itr = $1.listValue->begin(), end = $1.listValue->end(); itr != end; ++itr) 
+                            interpreter.output << "( ";
+                            for (vector<TYPE>::const_iterator itr = $1.listValue->begin(), end = $1.listValue->end(); itr != end; ++itr) 
                             {
                                 if(itr->type == INT)
                                 {
-                                    cout << itr->intValue;
+                                    interpreter.output << itr->intValue;
                                 }
                                 else if(itr->type == STR)
                                 {
-                                    cout << itr->stringValue;
+                                    interpreter.output << itr->stringValue;
                                 }
                                 else if(itr->type == BOOL)
                                 {
                                     if(itr->boolValue)
                                     {
-                                        cout << "TRUE";
+                                        interpreter.output << "TRUE";
                                     }
                                     else
                                     {
-                                        cout << "FALSE";
+                                        interpreter.output << "FALSE";
                                     }
                                 }
                                 else if(itr->type == FLOAT)
                                 {
-                                    cout << fixed << setprecision(2)<< itr->floatValue;
+                                    interpreter.output << fixed << setprecision(2)<< itr->floatValue;
                                 }
-                                cout << " ";
+                                interpreter.output << " ";
                             }
-                            cout << ")";
+                            interpreter.output << ")";
                             break;
                         case FUNCTION:
                             break;
                         default:
-                            cout << "reaches default case";
+                            interpreter.output << "reaches default case";
                             break;
                     }
 
@@ -382,7 +418,7 @@ N_EXPR:         N_IF_EXPR
                     $$.isParam = false;
                     $$.value = $1.value;
                     $$.listValue = $1.listValue;
-                    exit(1);
+                    throw MINIR_QUIT();
                 }
                 ;
 
@@ -393,6 +429,7 @@ N_CONST:        T_INTCONST
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
                     $$.isParam = false;
+                    $$.listValue = NULL;
                     $$.value.intValue =  $<intValue>1;
                     $$.value.type = INT;
                     //cout <<"intCONST =" << $$.value.intValue;
@@ -404,7 +441,11 @@ N_CONST:        T_INTCONST
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
                     $$.isParam = false;
-                    strcpy($$.value.stringValue, $<text>1);
+                    $$.listValue = NULL;
+                    size_t length = min((size_t) $<text>1.length,
+                                        sizeof($$.value.stringValue) - 1);
+                    memcpy($$.value.stringValue, $<text>1.start, length);
+                    $$.value.stringValue[length] = '\0';
                     $$.value.type = STR;
 
                 }
@@ -415,6 +456,7 @@ N_CONST:        T_INTCONST
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
                     $$.isParam = false;
+                    $$.listValue = NULL;
                     $$.value.floatValue =  $<floatValue>1;
                     $$.value.type = FLOAT;
                 }
@@ -425,6 +467,7 @@ N_CONST:        T_INTCONST
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
                     $$.isParam = false;
+                    $$.listValue = NULL;
                     $$.value.boolValue =  $<boolValue>1;
                     $$.value.type = BOOL;
                 }
@@ -435,65 +478,41 @@ N_CONST:        T_INTCONST
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
                     $$.isParam = false;
+                    $$.listValue = NULL;
                     $$.value.boolValue =  $<boolValue>1;
                     $$.value.type = BOOL;
                 }
                 ;
 
-N_COMPOUND_EXPR: T_LBRACE N_EXPR N_EXPR_LIST T_RBRACE
+N_COMPOUND_EXPR: T_LBRACE N_EXPR_LIST T_RBRACE
                 {
-                    printRule("COMPOUND_EXPR", "{ EXPR EXPR_LIST }");
-			        if ($3.type == NOT_APPLICABLE)
-			        {
-				        $$.type = $2.type;
-				        $$.numParams = $2.numParams;
-				        $$.returnType = $2.returnType;
-				        $$.isParam = $2.isParam;
-                        $$.value = $2.value;
-                        $$.listValue = $2.listValue;
-
-			        }
-			        else
-			        {
-				        $$.type = $3.type;
-				        $$.numParams = $3.numParams;
-				        $$.returnType = $3.returnType;
-				        $$.isParam = $3.isParam;
-                        $$.value = $3.value;
-                        $$.listValue = $3.listValue;
-			        }
+                    printRule("COMPOUND_EXPR", "{ EXPR_LIST }");
+                    $$ = $2;
                 }
                 ;
 
-N_EXPR_LIST:    T_SEMICOLON N_EXPR N_EXPR_LIST
+N_EXPR_LIST:    N_EXPR
                 {
-                    printRule("EXPR_LIST", "; EXPR EXPR_LIST");
-			        if ($3.type == NOT_APPLICABLE)
-			        {
-				        $$.type = $2.type;
-				        $$.numParams = $2.numParams;
-				        $$.returnType = $2.returnType;
-				        $$.isParam = $2.isParam;
-                        $$.value = $2.value;
-                        $$.listValue = $2.listValue;
-			        }
-			        else
-			        {
-				        $$.type = $3.type;
-				        $$.numParams = $3.numParams;
-			        	$$.returnType = $3.returnType;
-				        $$.isParam = $3.isParam;
-                        $$.value = $2.value;
-                        $$.listValue = $2.listValue;
-			        }
+                    printRule("EXPR_LIST", "EXPR");
+                    $$.type = $1.type;
+                    $$.numParams = $1.numParams;
+                    $$.returnType = $1.returnType;
+                    $$.isParam = $1.isParam;
+                    $$.value = $1.value;
+                    $$.listValue = $1.listValue;
                 }
-                | /* epsilon */
+                | N_EXPR_LIST T_SEMICOLON N_EXPR
                 {
-                    printRule("EXPR_LIST", "epsilon");
-                    $$.type = NOT_APPLICABLE;
-                    $$.numParams = NOT_APPLICABLE;
-                    $$.returnType = NOT_APPLICABLE;
-                    $$.isParam = false;
+                    // left-recursive, so each expression is reduced,
+                    // and so run, before the next is parsed, and the
+                    // list holds only the last one's value
+                    printRule("EXPR_LIST", "EXPR_LIST ; EXPR");
+                    $$.type = $3.type;
+                    $$.numParams = $3.numParams;
+                    $$.returnType = $3.returnType;
+                    $$.isParam = $3.isParam;
+                    $$.value = $3.value;
+                    $$.listValue = $3.listValue;
                 }
                 ;
 
@@ -517,7 +536,7 @@ N_IF_EXPR:      N_COND_IF T_RPAREN N_THEN_EXPR
                 {
                     printRule("IF_EXPR","IF ( EXPR ) EXPR ELSE EXPR");
                     if($5.type == FUNCTION)
-                        semanticError(3, ERR_CANNOT_BE_FUNCT);
+                        interpreter.semanticError(3, ERR_CANNOT_BE_FUNCT);
                     $$.type = $3.type ^ $5.type;
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
@@ -545,7 +564,7 @@ N_COND_IF:      T_IF T_LPAREN N_EXPR
                     || ($3.type == LIST)
                     || ($3.type == NULL_TYPE) 
                     || ($3.type == STR)) 
-                        semanticError(1, ERR_CANNOT_BE_FUNCT_NULL_LIST_OR_STR);
+                        interpreter.semanticError(1, ERR_CANNOT_BE_FUNCT_NULL_LIST_OR_STR);
                     $$.value = $3.value;
 			    }
 			    ; 
@@ -553,7 +572,7 @@ N_COND_IF:      T_IF T_LPAREN N_EXPR
 N_THEN_EXPR:    N_EXPR
 			    {
                     if($1.type == FUNCTION)
-                        semanticError(2, ERR_CANNOT_BE_FUNCT);
+                        interpreter.semanticError(2, ERR_CANNOT_BE_FUNCT);
                     $$.type = $1.type;
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
@@ -570,7 +589,7 @@ N_WHILE_EXPR:   T_WHILE T_LPAREN N_EXPR
                     || ($3.type == LIST)
                     || ($3.type == NULL_TYPE) 
                     || ($3.type == STR)) 
-                        semanticError(1, ERR_CANNOT_BE_FUNCT_NULL_LIST_OR_STR);
+                        interpreter.semanticError(1, ERR_CANNOT_BE_FUNCT_NULL_LIST_OR_STR);
                 }
                 T_RPAREN N_EXPR
                 {
@@ -584,13 +603,13 @@ N_WHILE_EXPR:   T_WHILE T_LPAREN N_EXPR
 N_FOR_EXPR:     T_FOR T_LPAREN T_IDENT 
                 {
                     printRule("FOR_EXPR", "FOR ( IDENT IN EXPR ) EXPR");
-                    string lexeme = string($3);
-                    TYPE_INFO exprTypeInfo = scopeStack.top().findEntry(lexeme);
+                    string lexeme = $3.str();
+                    TYPE_INFO exprTypeInfo = interpreter.scopeStack.top().findEntry(lexeme);
                     if(exprTypeInfo.type == UNDEFINED) 
                     {
                         if(!suppressTokenOutput)
-                            printf("___Adding %s to symbol" " table\n", $3);
-                        scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme,
+                            printf("___Adding %.*s to symbol" " table\n", $3.length, $3.start);
+                        interpreter.scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme,
                             {INT_OR_STR_OR_FLOAT_OR_BOOL, NOT_APPLICABLE, NOT_APPLICABLE,false}));
 			        }
 			        else
@@ -598,13 +617,13 @@ N_FOR_EXPR:     T_FOR T_LPAREN T_IDENT
 			            if( (exprTypeInfo.type == FUNCTION) 
                         ||(exprTypeInfo.type == NULL_TYPE) 
                         ||(exprTypeInfo.type == LIST))
-				            semanticError(1,ERR_CANNOT_BE_FUNCT_OR_NULL_OR_LIST);
+				            interpreter.semanticError(1,ERR_CANNOT_BE_FUNCT_OR_NULL_OR_LIST);
 			        }
                 }
 			    T_IN N_EXPR
 			    {
                     if($6.type != LIST) 
-				        semanticError(2, ERR_MUST_BE_LIST);
+				        interpreter.semanticError(2, ERR_MUST_BE_LIST);
 			    } 
 			    T_RPAREN N_EXPR
 			    {
@@ -623,39 +642,23 @@ N_LIST_EXPR:    T_LIST T_LPAREN N_CONST_LIST T_RPAREN
                     $$.returnType = NOT_APPLICABLE;
                     $$.isParam = false;
                     $$.value = $3.value;
-                    $$.listValue = new list<TYPE>;
-
                     $$.listValue = $3.listValue;
-                    //cout <<"size of N_LIST_EXPR = " <<$$.listValue->size() << endl;
-                    //for (list<TYPE>::const_iterator itr = $3.listValue->begin(), end = $3.listValue->end(); itr != end; ++itr) 
-                    //{
-                    //    $$.listValue->push_back(*itr);
-                   // }
-                    
                 }
                 ;
 
-N_CONST_LIST:   N_CONST T_COMMA N_CONST_LIST
+N_CONST_LIST:   N_CONST_LIST T_COMMA N_CONST
                 {
-                    printRule("CONST_LIST", "CONST, CONST_LIST");
+                    // left-recursive, so each constant is appended as
+                    // it is read instead of waiting on the parser
+                    // stack for the last one
+                    printRule("CONST_LIST", "CONST_LIST, CONST");
                     $$.type = LIST;
                     $$.numParams = $1.numParams;
                     $$.returnType = $1.returnType;
                     $$.isParam = $1.isParam;
                     $$.value = $1.value;
-                    $$.listValue = $3.listValue;
-
-                    //$1.listValue->push_back($1.value);
-                    //$1.listValue->front();
-                    //cout << "N_const_list =" <<$1.value.intValue << endl;
-
-                    $$.listValue->push_front($1.value);
-                    //cout<<"size = " <<$$.listValue->size() << endl;
-                    //for (list<TYPE>::const_iterator itr = $$.listValue->begin(), end = $$.listValue->end(); itr != end; ++itr) 
-                    //{
-                    //    cout << "what is inside list="<<itr->intValue <<endl;
-                    //}
-                    
+                    $$.listValue = $1.listValue;
+                    $$.listValue->push_back($3.value);
                 }
                 | N_CONST
                 {
@@ -665,36 +668,24 @@ N_CONST_LIST:   N_CONST T_COMMA N_CONST_LIST
                     $$.returnType = $1.returnType;
                     $$.isParam = $1.isParam;
                     $$.value = $1.value;
-                    //cout <<"liem";
-                    //cout <<"N_CONST="<< $1.value.intValue << endl;
-                    $$.listValue = new list<TYPE>;
-                    $$.listValue->push_front($1.value);
-                    //$$.listValue->front();
-                    
-                    //for (list<TYPE>::const_iterator itr = $$.listValue->begin(), end = $$.listValue->end(); itr != end; ++itr) 
-                    //{
-                    //    cout << itr->intValue;
-                    //}
-
-
-                    //cout << $$.listValue->size();
-                    //$$.listValue($1.listValue);
+                    $$.listValue = new vector<TYPE>;
+                    $$.listValue->push_back($1.value);
                 }
                 ;
 
 N_ASSIGNMENT_EXPR: T_IDENT N_INDEX
                 {
                     printRule("ASSIGNMENT_EXPR", "IDENT INDEX ASSIGN EXPR");
-                    string lexeme = string($1);
-                    TYPE_INFO exprTypeInfo = scopeStack.top().findEntry(lexeme);
+                    string lexeme = $1.str();
+                    TYPE_INFO exprTypeInfo = interpreter.scopeStack.top().findEntry(lexeme);
                     if(exprTypeInfo.type == UNDEFINED) 
 			        {
                         if(!suppressTokenOutput)
-                            printf("___Adding %s to symbol table\n", $1);
+                            printf("___Adding %.*s to symbol table\n", $1.length, $1.start);
                         // add in as N/A type until the
                         // N_EXPR can be processed below to 
                         // get the correct type
-                        scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme,
+                        interpreter.scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme,
                             {NOT_APPLICABLE, NOT_APPLICABLE,NOT_APPLICABLE, false}));
                         // set flag that ident didn't already 
 				        // exist
@@ -708,72 +699,66 @@ N_ASSIGNMENT_EXPR: T_IDENT N_INDEX
                 }
                 T_ASSIGN N_EXPR
                 {
-                    string lexeme = string($1);
-                    TYPE_INFO exprTypeInfo = scopeStack.top().findEntry(lexeme);
+                    string lexeme = $1.str();
+                    TYPE_INFO exprTypeInfo = interpreter.scopeStack.top().findEntry(lexeme);
                     if(($2.type == INDEX_PROD) && (!isListCompatible(exprTypeInfo.type))) 
-				        semanticError(1, ERR_MUST_BE_LIST);
+				        interpreter.semanticError(1, ERR_MUST_BE_LIST);
 			        if ($<flag>3)  // ident already existed 
                     {
 				        if (exprTypeInfo.isParam && !isIntCompatible($5.type))
-				            semanticError(1, ERR_MUST_BE_INTEGER);
-                        scopeStack.top().changeEntry(SYMBOL_TABLE_ENTRY(lexeme,
+				            interpreter.semanticError(1, ERR_MUST_BE_INTEGER);
+                        interpreter.scopeStack.top().changeEntry(SYMBOL_TABLE_ENTRY(lexeme,
                             {$5.type, $5.numParams, $5.returnType, false, $5.value, $5.listValue}));
                     }
                     else 
 			        {
                         // if ident didn't already exist, 
                         // just change the type
-                        scopeStack.top().changeEntry(SYMBOL_TABLE_ENTRY(lexeme,
+                        interpreter.scopeStack.top().changeEntry(SYMBOL_TABLE_ENTRY(lexeme,
                             {$5.type, $5.numParams, $5.returnType, false,$5.value, $5.listValue}));
                     }
 			        if (($2.type == INDEX_PROD) && ($5.type == LIST))
-				        semanticError(1, ERR_CANNOT_BE_LIST);
+				        interpreter.semanticError(1, ERR_CANNOT_BE_LIST);
 
                     if($2.type == INDEX_PROD)
                     {
-                        list<TYPE>::iterator itr = exprTypeInfo.listValue->begin();
-                        advance(itr, $2.value.intValue - 1);
-                        (*itr) = $5.value;
-                        
-                        if($2.value.intValue > exprTypeInfo.listValue->size())
-                        {
-                            semanticError(0, ERR_SUB_OUT_OF_BOUNDS);
-                        }
-                        else if($2.value.intValue == -1)
+                        if(($2.value.intValue < 1) 
+                        || ($2.value.intValue > (int) exprTypeInfo.listValue->size()))
                         {
-                            semanticError(0, ERR_SUB_OUT_OF_BOUNDS);
+                            interpreter.semanticError(0, ERR_SUB_OUT_OF_BOUNDS);
                         }
+                        (*exprTypeInfo.listValue)[$2.value.intValue - 1] = $5.value;
 
 
-                        cout << "( ";
-                        for (list<TYPE>::iterator itr = exprTypeInfo.listValue->begin(), end = exprTypeInfo.listValue->end(); itr != end; ++itr) 
+                        interpreter.output << "( ";
+                        for (vector<TYPE>::iterator itr = exprTypeInfo.listValue->begin(), end = exprTypeInfo.listValue->end(); itr != end; ++itr) 
                         {
                             if(itr->type == INT)
                             {
-                                cout << itr->intValue;
+                                interpreter.output << itr->intValue;
                             }
                             else if(itr->type == STR)
                             {
-                                cout << itr->stringValue;
+                                interpreter.output << itr->stringValue;
                             }
                             else if(itr->type == BOOL)
                             {
                                 if(itr->boolValue)
                                 {
-                                    cout << "TRUE";
+                                    interpreter.output << "TRUE";
                                 }
                                 else
                                 {
-                                    cout << "FALSE";
+                                    interpreter.output << "FALSE";
                                 }
                             }
                             else if(itr->type == FLOAT)
                             {
-                                cout << fixed << setprecision(2)<< itr->floatValue;
+                                interpreter.output << fixed << setprecision(2)<< itr->floatValue;
                             }
-                            cout << " ";
+                            interpreter.output << " ";
                         }
-                        cout << ")";
+                        interpreter.output << ")";
                         $$.listValue = exprTypeInfo.listValue;
                         $$.type = LIST;
 
@@ -789,13 +774,13 @@ N_ASSIGNMENT_EXPR: T_IDENT N_INDEX
                     }
                     //{
                     //    cout << "do i " << endl;
-                    //    list<TYPE>::const_iterator itr = exprTypeInfo.listValue->begin();
+                    //    vector<TYPE>::const_iterator itr = exprTypeInfo.listValue->begin();
                     //    advance(itr, $2.value.intValue - 1);
                     //    (*itr) = $5.value;
                     //    $$.type = LIST;
                     //}
 
-                    //for (list<TYPE>::const_iterator itr = $5.listValue->begin(), end = $5.listValue->end(); itr != end; ++itr) 
+                    //for (vector<TYPE>::const_iterator itr = $5.listValue->begin(), end = $5.listValue->end(); itr != end; ++itr) 
                     //{
                     //    $$.listValue->push_back(*itr);
                    // }
@@ -830,7 +815,7 @@ N_OUTPUT_EXPR:  T_PRINT T_LPAREN N_EXPR T_RPAREN
                 {
                     printRule("OUTPUT_EXPR", "PRINT ( EXPR )");
                     if(($3.type == FUNCTION) || ($3.type == NULL_TYPE)) 
-				        semanticError(1, ERR_CANNOT_BE_FUNCT_OR_NULL);
+				        interpreter.semanticError(1, ERR_CANNOT_BE_FUNCT_OR_NULL);
                     $$.type = $3.type;
                     $$.numParams = $3.numParams;
                     $$.returnType = $3.returnType;
@@ -842,7 +827,7 @@ N_OUTPUT_EXPR:  T_PRINT T_LPAREN N_EXPR T_RPAREN
                     //cout << "output size = " << $3.listValue->size()<< endl;
                     if($3.type == INT)
                     {
-                        cout << $3.value.intValue << endl;
+                        interpreter.output << $3.value.intValue << endl;
                         $$.value.intValue = $3.value.intValue;
                         $$.type = INT;
                     }
@@ -850,7 +835,7 @@ N_OUTPUT_EXPR:  T_PRINT T_LPAREN N_EXPR T_RPAREN
                     {
                         $$.value.floatValue = $3.value.floatValue;
                         $$.type = FLOAT;
-                        cout << $3.value.floatValue << endl;
+                        interpreter.output << $3.value.floatValue << endl;
                     }
                     else if($3.type == BOOL)
                     {
@@ -858,16 +843,16 @@ N_OUTPUT_EXPR:  T_PRINT T_LPAREN N_EXPR T_RPAREN
                         $$.type = BOOL;
                         if($3.value.boolValue)
                         {
-                            cout << "TRUE" << endl;
+                            interpreter.output << "TRUE" << endl;
                         }
                         else
                         {
-                            cout << "FALSE" << endl;
+                            interpreter.output << "FALSE" << endl;
                         }
                     }
                     else if($3.type == STR)
                     {
-                        cout << $3.value.stringValue << endl;
+                        interpreter.output << $3.value.stringValue << endl;
                         strcpy($$.value.stringValue, $3.value.stringValue);
                         $$.type = STR;
                     }
@@ -875,42 +860,42 @@ N_OUTPUT_EXPR:  T_PRINT T_LPAREN N_EXPR T_RPAREN
                     {
                         $$.listValue = $3.listValue;
                         $$.type = LIST;
-                        cout << "( ";
-                        for (list<TYPE>::const_iterator itr = $3.listValue->begin(), end = $3.listValue->end(); itr != end; ++itr) 
+                        interpreter.output << "( ";
+                        for (vector<TYPE>::const_iterator itr = $3.listValue->begin(), end = $3.listValue->end(); itr != end; ++itr) 
                         {
                             if(itr->type == INT)
                             {
-                                cout << itr->intValue;
+                                interpreter.output << itr->intValue;
                             }
                             else if(itr->type == STR)
                             {
-                                cout << itr->stringValue;
+                                interpreter.output << itr->stringValue;
                             }
                             else if(itr->type == BOOL)
                             {
                                 if(itr->boolValue)
                                 {
-                                    cout << "TRUE";
+                                    interpreter.output << "TRUE";
                                 }
                                 else
                                 {
-                                    cout << "FALSE";
+                                    interpreter.output << "FALSE";
                                 }
                             }
                             else if(itr->type == FLOAT)
                             {
-                                cout << fixed << setprecision(2)<< itr->floatValue;
+                                interpreter.output << fixed << setprecision(2)<< itr->floatValue;
                             }
-                            cout << " ";
+                            interpreter.output << " ";
                         }
-                        cout << ")" << endl;
+                        interpreter.output << ")" << endl;
                     }
                 }
                 | T_CAT T_LPAREN N_EXPR T_RPAREN
                 {
                     printRule("OUTPUT_EXPR","CAT ( EXPR )");
                     if(($3.type == FUNCTION) || ($3.type == NULL_TYPE)) 
-				        semanticError(1, ERR_CANNOT_BE_FUNCT_OR_NULL);
+				        interpreter.semanticError(1, ERR_CANNOT_BE_FUNCT_OR_NULL);
                     $$.type = NULL_TYPE;
                     $$.numParams = $3.numParams;
                     $$.returnType = $3.returnType;
@@ -922,61 +907,76 @@ N_OUTPUT_EXPR:  T_PRINT T_LPAREN N_EXPR T_RPAREN
                     //cout << "output size = " << $3.listValue->size()<< endl;
                     if($3.type == INT)
                     {
-                        cout << $3.value.intValue << endl;
+                        interpreter.output << $3.value.intValue << endl;
                     }
                     else if($3.type == FLOAT)
                     {
-                        cout << fixed << setprecision(2)<<$3.value.floatValue << endl;
+                        interpreter.output << fixed << setprecision(2)<<$3.value.floatValue << endl;
                     }
                     else if($3.value.type == BOOL)
                     {
                         if($3.value.boolValue)
                         {
-                            cout << "TRUE" << endl;
+                            interpreter.output << "TRUE" << endl;
                         }
                         else
                         {
-                            cout << "FALSE" << endl;
+                            interpreter.output << "FALSE" << endl;
                         }
                     }
                     else if($3.type == STR)
                     {
-                        cout << $3.value.stringValue << endl;
+                        interpreter.output << $3.value.stringValue << endl;
                     }
                     else//($3.value.type == LIST)
                     {
                         //cout << "output size = " << $3.listValue->size()<< endl;
-                        cout << "( ";
-                        for (list<TYPE>::const_iterator itr = $3.listValue->begin(), end = $3.listValue->end(); itr != end; ++itr) 
+                        interpreter.output << "( ";
+                        for (vector<TYPE>::const_iterator itr = $3.listValue->begin(), end = $3.listValue->end(); itr != end; ++itr) 
                         {
                             if(itr->type == INT)
                             {
-                                cout << itr->intValue;
+                                interpreter.output << itr->intValue;
                             }
                             else if(itr->type == STR)
                             {
-                                cout << itr->stringValue;
+                                interpreter.output << itr->stringValue;
                             }
                             else if(itr->type == BOOL)
                             {
                                 if(itr->boolValue)
                                 {
-                                    cout << "TRUE";
+                                    interpreter.output << "TRUE";
                                 }
                                 else
                                 {
-                                    cout << "FALSE";
+                                    interpreter.output << "FALSE";
                                 }
                             }
                             else if(itr->type == FLOAT)
                             {
-                                cout << fixed << setprecision(2)<< itr->floatValue;
+                                interpreter.output << fixed << setprecision(2)<< itr->floatValue;
                             }
-                            cout << " ";
+                            interpreter.output << " ";
                         }
-                        cout << ")" << endl;
+                        interpreter.output << ")" << endl;
                     }
                 }
+                | T_SAVERDS T_LPAREN N_EXPR T_COMMA N_EXPR T_RPAREN
+                {
+                    printRule("OUTPUT_EXPR", "SAVERDS ( EXPR , EXPR )");
+                    if(($3.type == FUNCTION) || ($3.type == NULL_TYPE)) 
+				        interpreter.semanticError(1, ERR_CANNOT_BE_FUNCT_OR_NULL);
+                    if($5.type != STR)
+                        interpreter.semanticError(2, ERR_MUST_BE_STR);
+                    if(!saveValue(unquote($5.value.stringValue).c_str(),
+                                  $3.type, $3.value, $3.listValue))
+                        interpreter.semanticError(2, ERR_CANNOT_OPEN_FILE);
+                    $$.type = NULL_TYPE;
+                    $$.numParams = NOT_APPLICABLE;
+                    $$.returnType = NOT_APPLICABLE;
+                    $$.isParam = false;
+                }
                 ;
 
 N_INPUT_EXPR:   T_READ T_LPAREN T_RPAREN
@@ -989,7 +989,7 @@ N_INPUT_EXPR:   T_READ T_LPAREN T_RPAREN
                     
                     
                     string in;
-                    getline(cin, in);
+                    interpreter.readLine(in);
                     //cout << "helo";
                     //cout <<"in="<< in <<endl;
                     //cout << "liem=" << in[0] <<endl;
@@ -1016,22 +1016,116 @@ N_INPUT_EXPR:   T_READ T_LPAREN T_RPAREN
                     }
 
                 }
+                | T_SCAN T_LPAREN N_EXPR T_RPAREN
+                {
+                    printRule("INPUT_EXPR", "SCAN ( EXPR )");
+                    if($3.type != STR)
+                        interpreter.semanticError(1, ERR_MUST_BE_STR);
+                    $$.type = LIST;
+                    $$.numParams = NOT_APPLICABLE;
+                    $$.returnType = NOT_APPLICABLE;
+                    $$.isParam = false;
+                    $$.listValue = new vector<TYPE>;
+                    int status = scanFile(unquote($3.value.stringValue).c_str(), $$.listValue);
+                    if(status != 0)
+                    {
+                        delete $$.listValue;
+                        $$.listValue = NULL;
+                    }
+                    if(status == -1)
+                        interpreter.semanticError(1, ERR_CANNOT_OPEN_FILE);
+                    else if(status == 1)
+                        interpreter.semanticError(1, ERR_NUMBER_OUT_OF_RANGE);
+                    else if(status != 0)
+                        interpreter.semanticError(1, ERR_STRING_TOO_LONG);
+                }
+                | T_READLINES T_LPAREN N_EXPR T_RPAREN
+                {
+                    printRule("INPUT_EXPR", "READLINES ( EXPR )");
+                    if($3.type != STR)
+                        interpreter.semanticError(1, ERR_MUST_BE_STR);
+                    $$.type = LIST;
+                    $$.numParams = NOT_APPLICABLE;
+                    $$.returnType = NOT_APPLICABLE;
+                    $$.isParam = false;
+                    $$.listValue = new vector<TYPE>;
+                    int status = readLinesFile(unquote($3.value.stringValue).c_str(), $$.listValue);
+                    if(status != 0)
+                    {
+                        delete $$.listValue;
+                        $$.listValue = NULL;
+                    }
+                    if(status == -1)
+                        interpreter.semanticError(1, ERR_CANNOT_OPEN_FILE);
+                    else if(status != 0)
+                        interpreter.semanticError(1, ERR_STRING_TOO_LONG);
+                }
+                | T_READCSV T_LPAREN N_EXPR T_COMMA N_EXPR T_RPAREN
+                {
+                    printRule("INPUT_EXPR", "READCSV ( EXPR , EXPR )");
+                    if($3.type != STR)
+                        interpreter.semanticError(1, ERR_MUST_BE_STR);
+                    if(($5.type != INT) && ($5.type != STR))
+                        interpreter.semanticError(2, ERR_MUST_BE_INT_OR_STR);
+                    // a column is picked by its header name or by
+                    // its position, counting from 1
+                    string name;
+                    if($5.type == STR)
+                        name = unquote($5.value.stringValue);
+                    int status = interpreter.csvTable.readColumn(
+                        unquote($3.value.stringValue).c_str(),
+                        ($5.type == STR) ? &name : NULL,
+                        $5.value.intValue - 1, &$$.listValue);
+                    if(status == CSV_CANNOT_OPEN)
+                        interpreter.semanticError(1, ERR_CANNOT_OPEN_FILE);
+                    else if(status == CSV_OUT_OF_RANGE)
+                        interpreter.semanticError(1, ERR_NUMBER_OUT_OF_RANGE);
+                    else if(status == CSV_MISSING_VALUE)
+                        interpreter.semanticError(1, ERR_MISSING_VALUE);
+                    else if(status == CSV_STRING_TOO_LONG)
+                        interpreter.semanticError(1, ERR_STRING_TOO_LONG);
+                    else if(status == CSV_NO_SUCH_COLUMN)
+                        interpreter.semanticError(2, ERR_SUB_OUT_OF_BOUNDS);
+
+                    $$.type = LIST;
+                    $$.numParams = NOT_APPLICABLE;
+                    $$.returnType = NOT_APPLICABLE;
+                    $$.isParam = false;
+                }
+                | T_READRDS T_LPAREN N_EXPR T_RPAREN
+                {
+                    printRule("INPUT_EXPR", "READRDS ( EXPR )");
+                    // the file is mapped, and the value copied out of it
+                    // once; see readListStore()
+                    if($3.type != STR)
+                        interpreter.semanticError(1, ERR_MUST_BE_STR);
+                    $$.numParams = NOT_APPLICABLE;
+                    $$.returnType = NOT_APPLICABLE;
+                    $$.isParam = false;
+                    $$.listValue = NULL;
+                    int status = loadValue(unquote($3.value.stringValue).c_str(),
+                                           &$$.type, &$$.value, &$$.listValue);
+                    if(status == -1)
+                        interpreter.semanticError(1, ERR_CANNOT_OPEN_FILE);
+                    else if(status != 0)
+                        interpreter.semanticError(1, ERR_BAD_DATA_FILE);
+                }
                 ;
 
 N_FUNCTION_DEF: T_FUNCTION
                 {
 			    printRule("FUNCTION_DEF", "FUNCTION ( PARAM_LIST )" " COMPOUND_EXPR");
-                beginScope();
+                interpreter.beginScope();
                 }
                 T_LPAREN N_PARAM_LIST
   		        {
-			        $<num>$ = scopeStack.top().getNumEntries();
+			        $<num>$ = interpreter.scopeStack.top().getNumEntries();
    		        }
 		        T_RPAREN N_COMPOUND_EXPR
                 {
-                    endScope();
+                    interpreter.endScope();
                     if($7.type == FUNCTION) 
-				        semanticError(2, ERR_CANNOT_BE_FUNCT);
+				        interpreter.semanticError(2, ERR_CANNOT_BE_FUNCT);
                     $$.type = FUNCTION;
                     $$.numParams = $<num>5;
                     $$.returnType = $7.type;
@@ -1058,41 +1152,41 @@ N_NO_PARAMS:    /* epsilon */
 N_PARAMS:       T_IDENT
                 {
                     printRule("PARAMS", "IDENT");
-                    string lexeme = string($1);
+                    string lexeme = $1.str();
                     if(!suppressTokenOutput)
-                        printf("___Adding %s to symbol table\n", $1);
+                        printf("___Adding %.*s to symbol table\n", $1.length, $1.start);
                     // assuming params are ints
                     TYPE_INFO exprTypeInfo = {INT, NOT_APPLICABLE, NOT_APPLICABLE, true};
-                    bool success = scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme, exprTypeInfo));
+                    bool success = interpreter.scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme, exprTypeInfo));
                     if(!success) 
-				        semanticError(0, ERR_MULTIPLY_DEFINED_IDENT);
+				        interpreter.semanticError(0, ERR_MULTIPLY_DEFINED_IDENT);
                 }
                 | T_IDENT T_COMMA N_PARAMS
                 {
                     printRule("PARAMS", "IDENT, PARAMS");
-                    string lexeme = string($1);
+                    string lexeme = $1.str();
                     if(!suppressTokenOutput)
-                        printf("___Adding %s to symbol table\n", $1);
+                        printf("___Adding %.*s to symbol table\n", $1.length, $1.start);
                     // assuming params are ints 
                     TYPE_INFO exprTypeInfo = {INT, NOT_APPLICABLE, NOT_APPLICABLE, true};
-                    bool success = scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme, exprTypeInfo));
+                    bool success = interpreter.scopeStack.top().addEntry(SYMBOL_TABLE_ENTRY(lexeme, exprTypeInfo));
                     if(!success) 
-				        semanticError(0, ERR_MULTIPLY_DEFINED_IDENT);
+				        interpreter.semanticError(0, ERR_MULTIPLY_DEFINED_IDENT);
                 }
                 ;
 
 N_FUNCTION_CALL: T_IDENT T_LPAREN N_ARG_LIST T_RPAREN
                 {
                     printRule("FUNCTION_CALL", "IDENT" " ( ARG_LIST )");
-                    TYPE_INFO exprTypeInfo = findEntryInAnyScope(string($1));
+                    TYPE_INFO exprTypeInfo = interpreter.findEntryInAnyScope($1.str());
                     if (exprTypeInfo.type == UNDEFINED) 
-                      semanticError(0, ERR_UNDEFINED_IDENT);
+                      interpreter.semanticError(0, ERR_UNDEFINED_IDENT);
                     if(exprTypeInfo.type != FUNCTION) 
-				        semanticError(1, ERR_MUST_BE_FUNCT);
+				        interpreter.semanticError(1, ERR_MUST_BE_FUNCT);
                     if($3 > exprTypeInfo.numParams) 
-				        semanticError(0, ERR_TOO_MANY_PARAMS);
+				        interpreter.semanticError(0, ERR_TOO_MANY_PARAMS);
                     if($3 < exprTypeInfo.numParams) 
-				        semanticError(0, ERR_TOO_FEW_PARAMS);
+				        interpreter.semanticError(0, ERR_TOO_FEW_PARAMS);
                     $$.type = exprTypeInfo.returnType;
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
@@ -1104,13 +1198,13 @@ N_ARG_LIST:     N_ARGS
                 {
                     printRule("ARG_LIST", "ARGS");
                     $$ = $1;
-                    numExprs = 0;
+                    interpreter.numExprs = 0;
                 }
                 | N_NO_ARGS
                 {
                     printRule("ARG_LIST", "NO_ARGS");
-                    numExprs = 0;
-                    $$ = numExprs;
+                    interpreter.numExprs = 0;
+                    $$ = interpreter.numExprs;
                 }
                 ;
 
@@ -1123,21 +1217,21 @@ N_NO_ARGS:      /* epsilon */
 N_ARGS:         N_EXPR
                 {
                     printRule("ARGS", "EXPR");
-                    numExprs++;
+                    interpreter.numExprs++;
                     if(!isIntCompatible($1.type)) 
-                        semanticError(0, ERR_NON_INT_FUNCT_PARAM);
-			        $$ = numExprs;
+                        interpreter.semanticError(0, ERR_NON_INT_FUNCT_PARAM);
+			        $$ = interpreter.numExprs;
                 }
                 | N_EXPR 
                 {
                     printRule("ARGS", "EXPR, ARGS");
-                    numExprs++;
+                    interpreter.numExprs++;
                     if(!isIntCompatible($1.type)) 
-				        semanticError(0, ERR_NON_INT_FUNCT_PARAM);
+				        interpreter.semanticError(0, ERR_NON_INT_FUNCT_PARAM);
                 }
 			    T_COMMA N_ARGS
 			    {
-			        $$ = numExprs;
+			        $$ = interpreter.numExprs;
 			    }
                 ;
 
@@ -1156,426 +1250,48 @@ N_ARITHLOGIC_EXPR: N_SIMPLE_ARITHLOGIC
                   N_SIMPLE_ARITHLOGIC
                 {
                     printRule("ARITHLOGIC_EXPR", "SIMPLE_ARITHLOGIC REL_OP " "SIMPLE_ARITHLOGIC");
-                    if(isInvalidOperandType($1.type))
-                    	semanticError(1,ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-                    if(isInvalidOperandType($3.type)) 
-                   	    semanticError(2, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-                    $$.type = BOOL; 
-                    $$.numParams = NOT_APPLICABLE;
-                    $$.returnType = NOT_APPLICABLE;
-                    $$.isParam = false;
-                    //cout << "**$1 = " <<$1.value.intValue << endl;
-                    //cout << "**$3 = " << $3.value.intValue << endl;
-                    //cout << "**$1type = " <<$1.value.type << endl;
-                    //cout << "**$3type = " << $3.value.type << endl;
-
-
-                    if($2 == LT)
-                    {
-                        //cout << "hello";
-                        if(($1.value.type == INT) && ($3.value.type == BOOL))
-                        {
-                            $$.value.boolValue = ($1.value.intValue < $3.value.boolValue);
-                        }
-                        else if(($1.value.type == BOOL) && ($3.value.type == INT))
-                        {
-                            $$.value.boolValue = ($1.value.boolValue < $3.value.intValue);
-                        }
-                        else if(($1.value.type == BOOL) && ($3.value.type == BOOL))
-                        {
-                            $$.value.boolValue = ($1.value.boolValue < $3.value.boolValue);
-                        }
-                        else
-                        {
-                            $$.value.boolValue = ($1.value.intValue < $3.value.intValue);
-                        }
-                    }
-                    else if($2 == GT)
-                    {
-                        //cout << "hello";
-                        if(($1.value.type == INT) && ($3.value.type == BOOL))
-                        {
-                            $$.value.boolValue = ($1.value.intValue > $3.value.boolValue);
-                        }
-                        else if(($1.value.type == BOOL) && ($3.value.type == INT))
-                        {
-                            $$.value.boolValue = ($1.value.boolValue > $3.value.intValue);
-                        }
-                        else if(($1.value.type == BOOL) && ($3.value.type == BOOL))
-                        {
-                            $$.value.boolValue = ($1.value.boolValue > $3.value.boolValue);
-                        }
-                        else
-                        {
-                            $$.value.boolValue = ($1.value.intValue > $3.value.intValue);
-                        }
-                    }
-                    else if($2 == EQ)
-                    {   
-                        if(($1.value.type == INT) && ($3.value.type == BOOL))
-                        {
-                            $$.value.boolValue = ($1.value.intValue == $3.value.boolValue);
-                        }
-                        else if(($1.value.type == BOOL) && ($3.value.type == INT))
-                        {
-                            $$.value.boolValue = ($1.value.boolValue == $3.value.intValue);
-                        }
-                        else
-                        {
-                            $$.value.boolValue = ($1.value.boolValue == $3.value.boolValue);
-                        }
-                    }
-                   // cout << "**final = " << $$.value.boolValue << endl;
-
-                }
-                ;
-
-N_SIMPLE_ARITHLOGIC: N_TERM N_ADD_OP_LIST
-                {
-                    printRule("SIMPLE_ARITHLOGIC", "TERM ADD_OP_LIST");
-			        if ($2.type != NOT_APPLICABLE)
-			        {
-                        if(isInvalidOperandType($1.type))
-                            semanticError(1, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-                        if(isInvalidOperandType($2.type))
-                            semanticError(2, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-                        //cout << "**$1 = " <<$1.value.type << endl;
-                        //cout << "**$2 = " << $2.value.type << endl;
-                        //cout << "mayb";
-                        if (isBoolCompatible($1.value.type) ||  isBoolCompatible($2.value.type))
-				        {    
-                            $$.type = BOOL;
-                            $$.value.type = BOOL;
-                            //cout << "eam i here="<<$$.value.boolValue << endl;
-                            if($2.value.op == OR)
-                            {
-                                $$.value.boolValue = ($1.value.boolValue || $2.value.boolValue);
-                            }
-                            //cout << "**$1 = " <<$1.value.boolValue << endl;
-                            //cout << "**$2 = " << $2.value.boolValue << endl;
-                            else 
-                            {
-                                $$.value.boolValue = $1.value.boolValue;
-                                
-                            }
-                            //if($2.value.op == AND)
-                            //{
-                            //    $$.value.boolValue = ($1.value.boolValue && $2.value.boolValue);
-                           // }
-                           //cout << "**$2 = " << $$.value.boolValue << endl;
-                        }
-				        else if (isIntCompatible($1.value.type) && isIntCompatible($2.value.type))
-                        {
-                            $$.type = INT;
-                            $$.value.type = INT;
-                            if($2.value.op == ADD)
-                            {
-                                $$.value.intValue = $1.value.intValue + $2.value.intValue;
-                            }
-                            if($2.value.op == SUB)
-                            {
-                                $$.value.intValue = $1.value.intValue - $2.value.intValue;
-                            }
-
-                        }
-                        else if (isFloatCompatible($1.value.type) || isFloatCompatible($2.value.type))
-				        {    
-                            $$.type = FLOAT;
-                            $$.value.type = FLOAT;
-                            
-                            if($2.value.op == ADD)
-                            {
-                                $$.value.floatValue = $1.value.floatValue + $2.value.floatValue
-                                        + $1.value.intValue + $2.value.intValue;
-                            }
-                            if($2.value.op == SUB)
-                            {
-                                $$.value.floatValue = $1.value.floatValue - $2.value.floatValue
-                                        - $1.value.intValue - $2.value.intValue;
-                            }
-                        }   
-
-				        else 
-                            $$.type = $1.type;
-				            $$.numParams = NOT_APPLICABLE;
-				            $$.returnType = NOT_APPLICABLE;
-                     	    $$.isParam = false;
-			        }
-                    else 
-			        {
-				        $$.type = $1.type;
-				        $$.numParams = $1.numParams;
-				        $$.returnType = $1.returnType;
-                    	$$.isParam = $1.isParam;
-                        $$.value = $1.value;
-                        $$.value.type = $1.type;
-			        }
-
-                
+                    applyBinaryOp(interpreter, $2, $1, $3, $$);
                 }
                 ;
 
-N_ADD_OP_LIST:  N_ADD_OP N_TERM N_ADD_OP_LIST
+N_SIMPLE_ARITHLOGIC: N_TERM
                 {
-                    printRule("ADD_OP_LIST", "ADD_OP TERM ADD_OP_LIST");
-			        int argWithErr = ($3.type == NOT_APPLICABLE)? 2: 1;
-                    if(isInvalidOperandType($2.type))             
-                        semanticError(argWithErr, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-			    
-                    $$.numParams = NOT_APPLICABLE;
-			        $$.returnType = NOT_APPLICABLE;
-                    $$.isParam = false;
-
-                    //cout << "**0" << endl;
-                    //cout << $$.value.floatValue << endl;
-                    //cout << $$.value.intValue << endl;
-                    //cout << $$.value.boolValue << endl;
-
-                    if($1 == OR)
-                    {
-				        $$.type = BOOL;
-                        $$.value.op = $1;
-                        $$.value.boolValue = $2.value.boolValue;
-                    }
-			        else
-			        {
-				        if($3.type == NOT_APPLICABLE)
-				        {
-                            $$.type = $2.type;
-                            $$.value.op = $1;
-                            $$.value.intValue = $2.value.intValue;
-                            $$.value.floatValue = $2.value.floatValue;
-                            $$.value.boolValue = $2.value.boolValue;
-                            $$.value.type = $2.value.type;
-                            strcpy($$.value.stringValue, $2.value.stringValue);
-                            //cout << "**1" << endl;
-                            //cout << $$.value.floatValue << endl;
-                            //cout << $$.value.intValue << endl;
-                            //cout << $$.value.boolValue << endl;
-                        }
-				        else
-				        {
-				            if (isIntCompatible($2.type) && isIntCompatible($3.type))
-                            {   
-                                $$.value.type = INT;
-                                if($3.value.op == ADD)
-                                {
-                                    $$.value.op = ADD;
-                                    $$.value.intValue = $3.value.intValue + $3.value.boolValue 
-                                                        + $2.value.intValue + $2.value.boolValue;
-                                }
-                                else if($3.value.op == SUB)
-                                {
-                                    $$.value.op = SUB;
-                                    $$.value.intValue = $3.value.intValue - $3.value.boolValue 
-                                                    - $2.value.intValue - $2.value.boolValue;
-                                }
-                            }
-                            else 
-                            {
-                                $$.value.type = FLOAT;
-                                //cout << $$.value.intValue << endl;
-                                //cout <<"type = " << $$.type << endl;
-                                //cout << $1.value.op;
-                                if($3.value.op == ADD)
-                                {
-                                    $$.value.op = ADD;
-                                    $$.value.floatValue = $3.value.floatValue + $3.value.intValue + $3.value.boolValue 
-                                        + $2.value.floatValue + $2.value.intValue + $2.value.boolValue;
-                                }
-                                else if($3.value.op == SUB)
-                                {
-                                    $$.value.op = SUB;
-                                    $$.value.floatValue = $3.value.floatValue - $3.value.intValue - $3.value.boolValue 
-                                        - $2.value.floatValue - $2.value.intValue - $2.value.boolValue;
-                                }
-                                //cout << $$.value.intValue;
-
-
-                            }
-				        }
-                    }
-                   // cout <<"endtype = " << $$.type << endl;
-
-                }
-                | /* epsilon */
-                {
-                    printRule("ADD_OP_LIST", "epsilon");
-			        $$.type = NOT_APPLICABLE;
-			        $$.numParams = NOT_APPLICABLE;
-			        $$.returnType = NOT_APPLICABLE;
-			        $$.isParam = false;
+                    printRule("SIMPLE_ARITHLOGIC", "TERM");
+                    $$ = $1;
+                    $$.value.type = $1.type;
                 }
-                ;
-
-N_TERM:         N_FACTOR N_MULT_OP_LIST
+                | N_SIMPLE_ARITHLOGIC N_ADD_OP N_TERM
                 {
-                    printRule("TERM", "FACTOR MULT_OP_LIST");
-			        if ($2.type != NOT_APPLICABLE)
-			        {
-				        if(isInvalidOperandType($1.type))
-                            semanticError(1, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-                     	if(isInvalidOperandType($2.type))
-                            semanticError(2, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-                     	
-                         $$.numParams = NOT_APPLICABLE;
-                     	$$.returnType = NOT_APPLICABLE;
-                    	$$.isParam = false;
-				        
-
-                        //cout  <<"act1=" << $1.value.boolValue << endl;
-                        //cout  <<"act2=" << $2.value.boolValue << endl;
-                        //cout << ($1.value.boolValue && $2.value.boolValue);
-                        if (isBoolCompatible($1.value.type) &&  isBoolCompatible($2.value.type))
-                            {
-                            if ($2.value.op == AND)
-				            {
-                                $$.type = BOOL;
-                                $$.value.type = BOOL;
-                                $$.value.boolValue = ($1.value.boolValue && $2.value.boolValue);
-                            }
-
-                        }
-				        else
-				        {
-				            if (isIntCompatible($1.value.type) && isIntCompatible($2.value.type))
-                            {
-                                $$.type = INT;
-                                if($2.value.op == MULT)
-                                {
-                                    $$.value.intValue = $1.value.intValue * $2.value.intValue;
-                                }
-                                else if($2.value.op == DIV)
-                                {
-                                    if($2.value.intValue == 0)
-                                    {
-                                        semanticError(0,ERR_ATTEMPTED_DIV_BY_ZERO);
-                                    }
-                                    else
-                                        $$.value.intValue = $1.value.intValue / $2.value.intValue;
-                                }
-                                else if($2.value.op == MOD)
-                                {
-                                    $$.value.intValue = $1.value.intValue % $2.value.intValue;
-                                }
-                                else if($2.value.op == POW)
-                                {
-                                    $$.value.intValue = pow($1.value.intValue, $2.value.intValue);
-                                }
-                            }
-                            else 
-                            {
-                                $$.type = FLOAT;
-                                if($2.value.op == MULT)
-                                {
-                                    $$.value.floatValue = $1.value.floatValue * $2.value.floatValue;
-                                }
-                                else if($2.value.op == DIV)
-                                {
-                                    if($2.value.type == INT)
-                                        if($2.value.intValue == 0)
-                                        {
-                                            semanticError(0,ERR_ATTEMPTED_DIV_BY_ZERO);
-                                        }
-                                        else
-                                            $$.value.floatValue = $1.value.floatValue / $2.value.intValue;
-                                    else if ($2.value.type == BOOL)
-                                        if($2.value.boolValue == 0)
-                                        {
-                                            semanticError(0,ERR_ATTEMPTED_DIV_BY_ZERO);
-                                        }
-                                        else
-                                            $$.value.floatValue = $1.value.floatValue / $2.value.boolValue;
-                                    else
-                                    {
-                                        if($2.value.floatValue == 0)
-                                        {
-                                            semanticError(0,ERR_ATTEMPTED_DIV_BY_ZERO);
-                                        }
-                                        $$.value.floatValue = $1.value.floatValue / $2.value.floatValue;
-                                    }
-                                }
-                                else if($2.value.op == MOD)
-                                {
-                                    $$.value.floatValue = fmod($1.value.floatValue, $2.value.floatValue);
-                                }
-                                else if($2.value.op == POW)
-                                {
-                                    if($2.value.type == INT)
-                                        $$.value.floatValue = pow($1.value.floatValue , $2.value.intValue);
-                                    else if ($2.value.type == BOOL)
-                                        $$.value.floatValue = pow($1.value.floatValue, $2.value.boolValue);
-                                    else
-                                        $$.value.floatValue = pow($1.value.floatValue, $2.value.floatValue);
-                                }
-                            }
-				        }
-			        }
-                    else 
-			        {
-				        $$.type = $1.type;
-				        $$.numParams = $1.numParams;
-				        $$.returnType = $1.returnType;
-				        $$.isParam = $1.isParam;
-                        $$.value = $1.value;
-			        }
+                    // left-recursive, so a chain a + b + ... reduces
+                    // as it goes instead of stacking every operand
+                    printRule("SIMPLE_ARITHLOGIC", "SIMPLE_ARITHLOGIC ADD_OP TERM");
+                    applyBinaryOp(interpreter, $2, $1, $3, $$);
                 }
                 ;
 
-N_MULT_OP_LIST: N_MULT_OP N_FACTOR N_MULT_OP_LIST
+N_TERM:         N_FACTOR
                 {
-                    printRule("MULT_OP_LIST", "MULT_OP FACTOR MULT_OP_LIST");
-			        int argWithErr = ($3.type == NOT_APPLICABLE)? 2: 1;
-                    if(isInvalidOperandType($2.type))                    				
-                        semanticError(argWithErr, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-			        $$.numParams = NOT_APPLICABLE;
-                    $$.returnType = NOT_APPLICABLE;
-			        $$.isParam = false;
-			        
-                    //if($1 == AND)
-                    //{
-                    //    $$.type = BOOL;
-                    //    $$.value.type = BOOL;
-                    //    $$.value.op = AND;
-                    //    $$.value.boolValue = $2.value.boolValue;
-                     //   $$.value.intValue = $2.value.intValue;
-                    //    $$.value.floatValue = $2.value.floatValue;
-                    //}
-                    //else
-                    //{
-                        if($3.type == NOT_APPLICABLE)
-				        {
-                            $$.type = $2.type;
-                            $$.value.op = $1;
-                            $$.value.intValue = $2.value.intValue;
-                            $$.value.floatValue = $2.value.floatValue;
-                            $$.value.boolValue = $2.value.boolValue;
-                            $$.value.type = $2.value.type;
-                            strcpy($$.value.stringValue, $2.value.stringValue);
-                        }
-			            else
-			            {
-                            if(isInvalidOperandType($3.type))                    				  
-                                semanticError(argWithErr, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
-				            if (isIntCompatible($2.type) && isIntCompatible($3.type))
-                            {
-				                $$.type = INT;
-                            }
-				            else 
-                            {
-                                $$.type = FLOAT;
-                            }
-			            }
-                    //}
+                    printRule("TERM", "FACTOR");
+                    $$ = $1;
                 }
-                
-                | /* epsilon */
+                | N_TERM N_MULT_OP N_FACTOR
                 {
-                    printRule("MULT_OP_LIST", "epsilon");
-			        $$.type = NOT_APPLICABLE;
-			        $$.numParams = NOT_APPLICABLE;
-			        $$.returnType = NOT_APPLICABLE;
-                    $$.isParam = false;
+                    printRule("TERM", "TERM MULT_OP FACTOR");
+                    // bison may reduce this before reading the next
+                    // token, but the old right-recursive rules had read
+                    // it, and the expected outputs give an error here
+                    // that token's line; so if there is no lookahead
+                    // yet, yylex() reports the error once it has read it
+                    try
+                    {
+                        applyBinaryOp(interpreter, $2, $1, $3, $$);
+                    }
+                    catch (const MINIR_ERROR& error)
+                    {
+                        if (yychar != YYEMPTY)
+                            throw;
+                        interpreter.pendingError = error.what();
+                    }
                 }
                 ;
 
@@ -1735,34 +1451,30 @@ N_SINGLE_ELEMENT: T_IDENT T_LBRACKET T_LBRACKET N_EXPR
                 {
                     printRule("SINGLE_ELEMENT", "IDENT"
                               " [[ EXPR ]]");
-                    TYPE_INFO exprTypeInfo = findEntryInAnyScope($1);
+                    TYPE_INFO exprTypeInfo = interpreter.findEntryInAnyScope($1.str());
                     if(exprTypeInfo.type == UNDEFINED) 
-				        semanticError(0, ERR_UNDEFINED_IDENT);
+				        interpreter.semanticError(0, ERR_UNDEFINED_IDENT);
                     if(!isListCompatible(exprTypeInfo.type)) 
-				        semanticError(1, ERR_MUST_BE_LIST);  
+				        interpreter.semanticError(1, ERR_MUST_BE_LIST);  
                     
                     //$$.type = INT_OR_STR_OR_FLOAT_OR_BOOL;
                     $$.numParams = NOT_APPLICABLE;
                     $$.returnType = NOT_APPLICABLE;
                     $$.isParam = false;
 
-                    //for (list<TYPE>::const_iterator itr = $1.listValue->begin(), end = $4.value.intValue; itr == end; ++itr) 
+                    //for (vector<TYPE>::const_iterator itr = $1.listValue->begin(), end = $4.value.intValue; itr == end; ++itr) 
                     //{
                         //$$.listValue->push_back(*itr);
                         //cout << itr.value.intValue;
                     //}
                     
-                    list<TYPE>::const_iterator itr = exprTypeInfo.listValue->begin();
-                    advance(itr, $4.value.intValue - 1);
-
-                    if($4.value.intValue == 0)
-                    {
-                        semanticError(0, ERR_SUB_OUT_OF_BOUNDS);
-                    }
-                    if($4.value.intValue > exprTypeInfo.listValue->size())
+                    if(($4.value.intValue < 1) 
+                    || ($4.value.intValue > (int) exprTypeInfo.listValue->size()))
                     {
-                        semanticError(0, ERR_SUB_OUT_OF_BOUNDS);
+                        interpreter.semanticError(0, ERR_SUB_OUT_OF_BOUNDS);
                     }
+                    vector<TYPE>::const_iterator itr = exprTypeInfo.listValue->begin()
+                                                       + ($4.value.intValue - 1);
 
 
                     //cout <<"index value ="<< (*itr).type << endl;
@@ -1776,7 +1488,7 @@ N_SINGLE_ELEMENT: T_IDENT T_LBRACKET T_LBRACKET N_EXPR
                     else if(itr->type == STR)
                     {
                         $$.type = STR;
-                        cout << itr->stringValue;
+                        interpreter.output << itr->stringValue;
                     }
                     else if(itr->type == BOOL)
                     {
@@ -1798,27 +1510,29 @@ N_SINGLE_ELEMENT: T_IDENT T_LBRACKET T_LBRACKET N_EXPR
 N_ENTIRE_VAR:   T_IDENT
                 {
                     printRule("ENTIRE_VAR", "IDENT");
-                    TYPE_INFO exprTypeInfo = findEntryInAnyScope(string($1));
+                    TYPE_INFO exprTypeInfo = interpreter.findEntryInAnyScope($1.str());
                     if(exprTypeInfo.type == UNDEFINED)
-                      semanticError(0, ERR_UNDEFINED_IDENT);
+                      interpreter.semanticError(0, ERR_UNDEFINED_IDENT);
                     
                     $$.type = exprTypeInfo.type;
                     $$.numParams = exprTypeInfo.numParams;
                     $$.returnType = exprTypeInfo.returnType;
                     $$.isParam = exprTypeInfo.isParam;
+                    $$.value = exprTypeInfo.value;
+                    $$.listValue = exprTypeInfo.listValue;
                 }
                 ;
 
 %%
 
 #include "lex.yy.c"
-extern FILE *yyin;
+#include "FastScanner.h"
 
 //  Construct a string as an argument number (argNum, 0
 //  if no argument number in message) and message (errNum is
-//  index position in ERR_MSG[]). Then call yyerror with that
-//  string.
-void semanticError(const int argNum, const int errNum)
+//  index position in ERR_MSG[]). Then throw it as a MINIR_ERROR,
+//  which run() reports.
+void INTERPRETER::semanticError(const int argNum, const int errNum)
 {
   string errorMsg;
   int errNo = errNum;
@@ -1829,12 +1543,14 @@ void semanticError(const int argNum, const int errNum)
     errorMsg = "Arg " + to_string(argNum) + " ";
   else errorMsg = "";
   errorMsg += ERR_MSG[errNo];
-  yyerror(errorMsg.c_str());
+  TRACE::eval("semantic error", errorMsg.c_str());
+  throw MINIR_ERROR(lineNum, errorMsg);
 }
 
 // Output type and lexeme.
 void printTokenInfo(const char* token_type, const char* lexeme)
 {
+  TRACE::token(token_type, lexeme);
   if(!suppressTokenOutput) 
   {
     printf("TOKEN: %s \t\t LEXEME: %s\n", token_type, lexeme);
@@ -1845,6 +1561,8 @@ void printTokenInfo(const char* token_type, const char* lexeme)
 // param) and symbols on right-hand side (2nd param).
 void printRule(const char *lhs, const char *rhs)
 {
+  PROFILE_RULE(lhs, rhs);
+  TRACE::rule(lhs, rhs);
   if(!suppressTokenOutput) 
   {
     printf("%s -> %s\n", lhs, rhs);
@@ -1896,24 +1614,353 @@ bool isInvalidOperandType(const int theType)
 		(theType == STR));
 }
 
+// Return x's type if it is INT, FLOAT or BOOL, or else the type of
+// the value it holds (x may be a variable with a combined type code,
+// such as a function parameter).
+int scalarTypeOf(const TYPE_INFO& x)
+{
+    if ((x.type == INT) || (x.type == FLOAT) || (x.type == BOOL))
+        return(x.type);
+    return(x.value.type);
+}
+
+// Evaluate left op right, where op is an ADD_OP, MULT_OP or REL_OP,
+// into result, by the kernel in BINARY_KERNELS for op and the
+// operands' types.
+void applyBinaryOp(INTERPRETER& interpreter, const int op, const TYPE_INFO& left,
+                   const TYPE_INFO& right, TYPE_INFO& result)
+{
+    // a relational operator reports its left operand first, the
+    // others their right one, as the rules they came from did
+    bool isRelational = (op >= LT);
+    if (isRelational && isInvalidOperandType(left.type))
+        interpreter.semanticError(1, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
+    if (isInvalidOperandType(right.type))
+        interpreter.semanticError(2, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
+    if (isInvalidOperandType(left.type))
+        interpreter.semanticError(1, ERR_MUST_BE_INT_FLOAT_OR_BOOL);
+
+    memset(&result.value, 0, sizeof(result.value));
+    result.numParams = NOT_APPLICABLE;
+    result.returnType = NOT_APPLICABLE;
+    result.isParam = false;
+    result.listValue = NULL;
+    result.value.op = op;
+    BINARY_KERNELS[op - FIRST_OPERATOR][tagOf(scalarTypeOf(left))][tagOf(scalarTypeOf(right))]
+        (interpreter, left.value, right.value, result.value);
+    result.type = result.value.type;
+}
+
+// Return text without the surrounding double quotes that a
+// STRCONST keeps from its lexeme.
+string unquote(const char* text)
+{
+    size_t len = strlen(text);
+    if ((len >= 2) && (text[0] == '"') && (text[len-1] == '"'))
+        return(string(text + 1, len - 2));
+    return(string(text));
+}
+
+// Run the script in file. The scanner works on the script in
+// memory, so read all of it first.
+int INTERPRETER::run(FILE* file)
+{
+    if (file == NULL)
+        file = stdin;
+    vector<char> buffer;
+    char block[65536];
+    size_t n;
+    while ((n = fread(block, 1, sizeof(block), file)) > 0)
+        buffer.insert(buffer.end(), block, block + n);
+    size_t size = buffer.size();
+    buffer.resize(size + 2, '\0');
+
+    cleanUp();
+    int status = evaluateBuffer(&buffer[0], size);
+    cleanUp();
+    return(status);
+}
+
+// Run the script in the file named fileName, mapped into memory.
+int INTERPRETER::runFile(const string fileName)
+{
+    // flex wants two NULs after the text
+    MAPPED_FILE file;
+    if (!file.openPadded(fileName.c_str(), 2))
+    {
+        // not a regular file; run() reads what it can
+        FILE* in = fopen(fileName.c_str(), "r");
+        int status = run(in);
+        if (in != NULL)
+            fclose(in);
+        return(status);
+    }
+    cleanUp();
+    int status = evaluateBuffer((char*) file.getData(), file.getSize());
+    cleanUp();
+    return(status);
+}
+
+// Run the script in source, keeping the outermost scope (and so
+// the variables in it) from one call to the next.
+int INTERPRETER::evaluate(const string source)
+{
+    vector<char> buffer(source.begin(), source.end());
+    buffer.resize(source.size() + 2, '\0');
+    return(evaluateBuffer(&buffer[0], source.size()));
+}
+
+// Run the size bytes of script at buffer, which are followed by two
+// NULs. The scanner works in place, and tokens' text points into
+// buffer, so it must last until this returns.
+int INTERPRETER::evaluateBuffer(char* buffer, const size_t size)
+{
+    yyscan_t scanner;
+    if (yylex_init_extra(this, &scanner) != 0)
+        return(1);
+    yy_scan_buffer(buffer, size + 2, scanner);
+    if (scopeStack.empty())
+        beginScope();
+    lineNum = 1;
+    pendingError.clear();
+    FAST_SCANNER fast(buffer, size, lineNum, scannerKind);
+    if (scannerKind != SCANNER_FLEX)
+        fastScanner = &fast;
+
+    // replay the script's tokens from the cache, scanning them all
+    // into it first if they are not there yet
+    TOKEN_STREAM stream;
+    if (!cacheDir.empty())
+    {
+        uint64_t hash = TOKEN_STREAM::hashOf(buffer, size);
+        string cacheFile = TOKEN_STREAM::fileNameFor(cacheDir, hash);
+        if (!stream.load(cacheFile, hash, size))
+        {
+            scanAll(scanner, stream);
+            stream.save(cacheFile, hash, size);
+            lineNum = 1;
+        }
+        tokens = &stream;
+    }
+
+    int status = parse(scanner);
+    tokens = NULL;
+    fastScanner = NULL;
+    // an error inside a function body leaves its scopes behind
+    while (scopeStack.size() > 1)
+        endScope();
+    yylex_destroy(scanner);
+    return(status);
+}
+
+// Fill stream with every token scanner produces, through the end
+// of its input.
+void INTERPRETER::scanAll(void* scanner, TOKEN_STREAM& stream)
+{
+    YYSTYPE value;
+    CACHED_TOKEN token;
+    do
+    {
+        memset(&token, 0, sizeof(token));
+        const TOKEN_TEXT* text = NULL;
+        TOKEN_TEXT message;
+        string what;
+        try
+        {
+            token.token = nextToken(&value, scanner);
+        }
+        catch (const MINIR_ERROR& error)
+        {
+            // recorded so that the replay throws it where the scanner
+            // did, after the expressions before it have run
+            token.token = TOKEN_ERROR;
+            what = error.what();
+            message.start = what.data();
+            message.length = what.size();
+            text = &message;
+        }
+        token.line = lineNum;
+        switch (token.token)
+        {
+            case T_IDENT:
+            case T_STRCONST:
+                text = &value.text;
+                break;
+            case T_INTCONST:
+                token.value.intValue = value.intValue;
+                break;
+            case T_FLOATCONST:
+                token.value.floatValue = value.floatValue;
+                break;
+            case T_TRUE:
+            case T_FALSE:
+                token.value.boolValue = value.boolValue;
+                break;
+        }
+        stream.add(token, text);
+    } while ((token.token != 0) && (token.token != TOKEN_ERROR));
+}
+
+// Return the next token for the parser, or throw the error an
+// action left pending, with the line of that token.
+int yylex(YYSTYPE* yylval_param, void* yyscanner)
+{
+    int token = nextToken(yylval_param, yyscanner);
+    INTERPRETER* interpreter = yyget_extra(yyscanner);
+    if (!interpreter->pendingError.empty())
+    {
+        string message;
+        message.swap(interpreter->pendingError);
+        throw MINIR_ERROR(interpreter->lineNum, message);
+    }
+    return(token);
+}
+
+// Return the next token: from the cached stream the interpreter is
+// replaying, if any, or else from the scanner it uses.
+int nextToken(YYSTYPE* yylval_param, void* yyscanner)
+{
+    // bison's yylval is an uninitialized local of yyparse(), and
+    // rules that start with a token begin with the token's value as
+    // their $$; clear it so that no listValue they leave unset is
+    // garbage
+    memset(yylval_param, 0, sizeof(*yylval_param));
+    INTERPRETER* interpreter = yyget_extra(yyscanner);
+    if (interpreter->tokens == NULL)
+    {
+        if (interpreter->fastScanner != NULL)
+            return(interpreter->fastScanner->scan(yylval_param));
+        return(scanToken(yylval_param, yyscanner));
+    }
+
+    const CACHED_TOKEN* token = interpreter->tokens->nextToken();
+    if (token == NULL)
+        return(0);
+    interpreter->lineNum = token->line;
+    switch (token->token)
+    {
+        case T_IDENT:
+        case T_STRCONST:
+            yylval_param->text = interpreter->tokens->textOf(token);
+            break;
+        case T_INTCONST:
+            yylval_param->intValue = token->value.intValue;
+            break;
+        case T_FLOATCONST:
+            yylval_param->floatValue = token->value.floatValue;
+            break;
+        case T_TRUE:
+        case T_FALSE:
+            yylval_param->boolValue = token->value.boolValue;
+            break;
+        case TOKEN_ERROR:
+            throw MINIR_ERROR(token->line, interpreter->tokens->textOf(token).str());
+    }
+    return(token->token);
+}
+
+// Parse the script's top-level expression, reporting an error on
+// output.
+int INTERPRETER::parse(void* scanner)
+{
+    int status = 0;
+    try
+    {
+        // yyparse() returns after one expression. This used to loop
+        // until flex's FILE hit its end, which for any script under
+        // flex's 8K read was after the first; with the script in
+        // memory it is at its end from the start.
+        yyparse(*this, scanner);
+    }
+    catch (const MINIR_ERROR& error)
+    {
+        output << "Line " << error.getLine() << ": " << error.what() << "\n";
+        status = 1;
+    }
+    catch (const MINIR_QUIT&)
+    {
+        status = 1;
+    }
+    output.flush();
+    return(status);
+}
+
+// Send output to handler; an empty handler means stdout.
+void INTERPRETER::setOutputHandler(const OUTPUT_HANDLER handler)
+{
+    if (handler)
+        outputBuffer.setHandler(handler);
+    else
+        outputBuffer.setHandler([](const char* text, size_t length)
+                                { fwrite(text, 1, length, stdout); });
+}
+
+// Take read()'s input from handler; an empty handler means stdin.
+void INTERPRETER::setInputHandler(const INPUT_HANDLER handler)
+{
+    if (handler)
+        inputHandler = handler;
+    else
+        inputHandler = [](string& line) { return((bool) getline(cin, line)); };
+}
+
+// Give the variable name value in the outermost scope.
+void INTERPRETER::setVariable(const string name, const TYPE_INFO value)
+{
+    if (scopeStack.empty())
+        beginScope();
+    TYPE_INFO info = value;
+    vector<TYPE> empty;
+    if ((info.type == LIST) && (info.listValue == NULL))
+        info.listValue = &empty;
+    setInOutermostScope(SYMBOL_TABLE_ENTRY(name, info));
+}
+
+// Add entry to the bottom SYMBOL_TABLE in scopeStack, or replace
+// the one there with its name.
+void INTERPRETER::setInOutermostScope(const SYMBOL_TABLE_ENTRY& entry)
+{
+    if (scopeStack.size() == 1)
+    {
+        if (!scopeStack.top().addEntry(entry))
+            scopeStack.top().changeEntry(entry);
+        return;
+    }
+    SYMBOL_TABLE symbolTable = scopeStack.top();
+    scopeStack.pop();
+    setInOutermostScope(entry);
+    scopeStack.push(symbolTable); // restore the stack
+}
+
+// Return the list that name holds, or NULL if it is not a list.
+vector<TYPE>* INTERPRETER::getList(const string name)
+{
+    TYPE_INFO info = findEntryInAnyScope(name);
+    if (info.type != LIST)
+        return(NULL);
+    return(info.listValue);
+}
+
 // Push a new SYMBOL_TABLE onto scopeStack.
-void beginScope() 
+void INTERPRETER::beginScope() 
 {
     scopeStack.push(SYMBOL_TABLE());
+    TRACE::beginScope();
     if(!suppressTokenOutput)
-        printf("\n___Entering new scope...\n\n");
+        output << "\n___Entering new scope...\n\n";
 }
 
 // Pop a SYMBOL_TABLE from scopeStack.
-void endScope() 
+void INTERPRETER::endScope() 
 {
     scopeStack.pop();
+    TRACE::endScope();
     if(!suppressTokenOutput)
-        printf("\n___Exiting scope...\n\n");
+        output << "\n___Exiting scope...\n\n";
 }
 
 // Pop all SYMBOL_TABLE's from scopeStack.
-void cleanUp() 
+void INTERPRETER::cleanUp() 
 {
     if (scopeStack.empty())
         return;
@@ -1926,12 +1973,23 @@ void cleanUp()
 // If the_name exists in any SYMBOL_TABLE in scopeStack, return
 // its TYPE_INFO; otherwise, return a TYPE_INFO that contains
 // type UNDEFINED.
-TYPE_INFO findEntryInAnyScope(const string the_name) 
+TYPE_INFO INTERPRETER::findEntryInAnyScope(const string the_name) 
+{
+    int numScopes = 0;
+    TYPE_INFO info = findEntryInScopes(the_name, numScopes);
+    PROFILE_SCOPE_DEPTH(numScopes);
+    return(info);
+}
+
+// Search scopeStack from the top down for the_name, counting the
+// scopes searched in numScopes.
+TYPE_INFO INTERPRETER::findEntryInScopes(const string the_name, int& numScopes) 
 {
     TYPE_INFO info = {UNDEFINED, NOT_APPLICABLE, NOT_APPLICABLE};
     if (scopeStack.empty()) 
         return(info);
     
+    numScopes++;
     info = scopeStack.top().findEntry(the_name);
     
     if (info.type != UNDEFINED) 
@@ -1940,25 +1998,41 @@ TYPE_INFO findEntryInAnyScope(const string the_name)
     {   // check in "next higher" scope
         SYMBOL_TABLE symbolTable = scopeStack.top();
         scopeStack.pop();
-        info = findEntryInAnyScope(the_name);
+        info = findEntryInScopes(the_name, numScopes);
         scopeStack.push(symbolTable); // restore the stack
         return(info);
     }
 }
 
+// Return the SCANNER_ code for name: flex, fast (or none), sse2 or
+// avx2.
+int scannerKindOf(const char* name)
+{
+    if (name == NULL)
+        return(SCANNER_FAST);
+    else if (strcmp(name, "flex") == 0)
+        return(SCANNER_FLEX);
+    else if (strcmp(name, "sse2") == 0)
+        return(SCANNER_SSE2);
+    else if (strcmp(name, "avx2") == 0)
+        return(SCANNER_AVX2);
+    return(SCANNER_FAST);
+}
 
+// bench.cpp and other drivers that #include this file supply
+// their own main()
+#ifndef MINIR_NO_MAIN
 int main(int argc, char** argv) 
 {
-    beginScope();
     if (argc < 2) 
     {
         printf("You must specify a file in the command line!\n");
         exit(1);
     }
-    yyin = fopen(argv[1], "r");
-    do 
-    {
-        yyparse();
-    } while (!feof(yyin));
-    return 0;
-}
\ No newline at end of file
+    INTERPRETER interpreter;
+    if (getenv("MINIR_CACHE_DIR") != NULL)
+        interpreter.cacheDir = getenv("MINIR_CACHE_DIR");
+    interpreter.scannerKind = scannerKindOf(getenv("MINIR_SCANNER"));
+    return(interpreter.runFile(argv[1]));
+}
+#endif  // MINIR_NO_MAIN
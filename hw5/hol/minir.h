@@ -0,0 +1,90 @@
+/*
+    minir.h
+
+    The interface for programs that embed the interpreter (libminir),
+    rather than running ./parser on a file per script.
+
+    bash hw5_lib.sh         (builds hol/libminir.a)
+    g++ -std=c++11 -O2 -pthread -Ihol myprog.cpp hol/libminir.a -lrt
+
+    A script is one top-level expression, as for ./parser; evaluate()
+    runs the first and parses nothing after it, so several go in one
+    call as { a = 1; b = 2 }. An INTERPRETER keeps its outermost scope
+    between evaluate() calls, so variables set by one script, or by
+    setVariable(), are there for the next:
+
+        INTERPRETER interpreter;
+        interpreter.printResults = false;
+        interpreter.setOutputHandler(
+            [&](const char* text, size_t length) { reply.append(text, length); });
+        interpreter.setVariable("rate", makeFloat(0.25));
+        interpreter.setVariable("prices", makeList());
+        interpreter.getList("prices")->push_back(price);
+        if (interpreter.evaluate("print(rate * 4.0)") == 0)
+            ... reply has the output, interpreter.result the value ...
+
+    A list variable's storage is read and filled in place through
+    getList(); setVariable(name, makeList()) makes an empty one.
+    Each INTERPRETER is independent, so a thread can have its own;
+    one must not be used by two threads at once.
+*/
+
+#ifndef MINIR_H
+#define MINIR_H
+
+#include <string.h>
+#include <string>
+#include <vector>
+#include "SymbolTableEntry.h"
+#include "Interpreter.h"
+using namespace std;
+
+// Return a TYPE_INFO holding a value of the given type, for
+// setVariable().
+inline TYPE_INFO makeValue(const int theType)
+{
+  TYPE_INFO info = {theType, NOT_APPLICABLE, NOT_APPLICABLE, false};
+  info.value.type = theType;
+  info.listValue = NULL;
+  return(info);
+}
+
+inline TYPE_INFO makeInt(const int x)
+{
+  TYPE_INFO info = makeValue(INT);
+  info.value.intValue = x;
+  return(info);
+}
+
+inline TYPE_INFO makeFloat(const float x)
+{
+  TYPE_INFO info = makeValue(FLOAT);
+  info.value.floatValue = x;
+  return(info);
+}
+
+inline TYPE_INFO makeBool(const bool x)
+{
+  TYPE_INFO info = makeValue(BOOL);
+  info.value.boolValue = x;
+  return(info);
+}
+
+// x is cut to fit TYPE's stringValue.
+inline TYPE_INFO makeString(const string x)
+{
+  TYPE_INFO info = makeValue(STR);
+  strncpy(info.value.stringValue, x.c_str(), sizeof(info.value.stringValue) - 1);
+  info.value.stringValue[sizeof(info.value.stringValue) - 1] = '\0';
+  return(info);
+}
+
+// elements is copied into the variable; NULL makes an empty list.
+inline TYPE_INFO makeList(vector<TYPE>* elements = NULL)
+{
+  TYPE_INFO info = makeValue(LIST);
+  info.listValue = elements;
+  return(info);
+}
+
+#endif  // MINIR_H
@@ -0,0 +1,687 @@
+/*
+    minir_gen.cpp
+
+    Generates valid MiniR programs of a chosen size and shape, for
+    scale testing the interpreter. Programs mix the constructs the
+    sample_input categories cover: arithmetic, relational and
+    logical expressions, scalar/list/indexed assignment, list
+    literals and indexing, if/else, loops, print/cat and function
+    definitions and calls.
+
+    g++ -O2 minir_gen.cpp -o minir_gen
+    ./minir_gen --tokens 1000000 --block 100 --seed 7 > big.txt
+    ./parser big.txt
+
+    Options (defaults in brackets):
+      --tokens N      stop after about N tokens [1000]
+      --depth N       max expression nesting depth [3]
+      --ops A,R,L     weights of arithmetic, relational and logical
+                      operators [6,2,2]
+      --idents N      # of distinct scalar variables [8]
+      --nesting N     max nesting of function definitions and
+                      if/loop bodies [2]
+      --list-len N    length of list literals [8]
+      --loops P       % of statements that are for/while loops [10]
+      --calls P       % of operands that are function calls [10]
+      --block N       group statements into nested { } blocks of at
+                      most N (0 = one flat block) [0]
+      --seed N        random seed [1]
+
+    Every program is one compound expression, the way the parser
+    reads a file. With --block 0 its statement list is as long as
+    the program, so a few thousand statements (or a --list-len of
+    a few thousand) overflow the parser stack; --block keeps every
+    statement list short.
+
+    The interpreter's rules shape what is generated: division and
+    %% only ever take a positive constant divisor, list subscripts
+    and function arguments only use constants and parameters, calls
+    are parenthesized to be operands, and indexed assignment only
+    targets lists of the current scope.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+using namespace std;
+
+typedef struct {
+  string name;
+  int length;
+} LIST_VAR;
+
+typedef struct {
+  string name;
+  int numParams;
+} FUNCTION_VAR;
+
+// The names a generated statement may refer to in one scope.
+typedef struct {
+  vector<string> numVars;       // INT/FLOAT/BOOL variables
+  vector<string> params;        // INT function parameters
+  vector<LIST_VAR> lists;       // numeric lists
+  vector<FUNCTION_VAR> functions;
+} SCOPE;
+
+class GENERATOR
+{
+private:
+  // options
+  long long targetTokens;
+  int maxDepth;
+  int arithWeight, relWeight, logicWeight;
+  int numIdents;
+  int maxNesting;
+  int listLength;
+  int loopPercent;
+  int callPercent;
+  int blockSize;
+
+  mt19937 rng;
+  string out;
+  long long numTokens;
+  int indent;
+  vector<SCOPE> scopes;         // innermost last
+
+  int pick(const int n) { return(uniform_int_distribution<int>(0, n - 1)(rng)); }
+  bool chance(const int percent) { return(pick(100) < percent); }
+
+  // Append one token.
+  void emit(const string token)
+  {
+    out += token;
+    out += ' ';
+    numTokens++;
+  }
+
+  void newline()
+  {
+    out += '\n';
+    out.append(indent * 2, ' ');
+  }
+
+  string intConst(const int lo, const int hi)
+  {
+    return(to_string(lo + pick(hi - lo + 1)));
+  }
+
+  string floatConst()
+  {
+    return(to_string(pick(100)) + "." + to_string(10 + pick(90)));
+  }
+
+  static const string& nameOf(const string& name) { return(name); }
+  static const string& nameOf(const LIST_VAR& l) { return(l.name); }
+  static const string& nameOf(const FUNCTION_VAR& f) { return(f.name); }
+
+  template <class T>
+  static bool contains(const vector<T>& names, const string name)
+  {
+    for (size_t i = 0; i < names.size(); i++)
+      if (nameOf(names[i]) == name)
+        return(true);
+    return(false);
+  }
+
+  // Determine whether name is declared in a scope inside scopes[level].
+  bool isShadowed(const string name, const size_t level)
+  {
+    for (size_t i = level + 1; i < scopes.size(); i++)
+      if (contains(scopes[i].numVars, name) || contains(scopes[i].params, name)
+      || contains(scopes[i].lists, name) || contains(scopes[i].functions, name))
+        return(true);
+    return(false);
+  }
+
+  // Return the visible names of one kind, leaving out those an inner
+  // scope hides.
+  template <class T>
+  vector<T> visible(vector<T> SCOPE::*member)
+  {
+    vector<T> all;
+    for (size_t i = 0; i < scopes.size(); i++)
+    {
+      const vector<T>& names = scopes[i].*member;
+      for (size_t j = 0; j < names.size(); j++)
+        if (!isShadowed(nameOf(names[j]), i))
+          all.push_back(names[j]);
+    }
+    return(all);
+  }
+
+  void addName(vector<string>& names, const string name)
+  {
+    if (!contains(names, name))
+      names.push_back(name);
+  }
+
+  void genCall()
+  {
+    vector<FUNCTION_VAR> functions = visible(&SCOPE::functions);
+    const FUNCTION_VAR& f = functions[pick(functions.size())];
+    emit(f.name);
+    emit("(");
+    for (int i = 0; i < f.numParams; i++)
+    {
+      if (i > 0)
+        emit(",");
+      genIntArg();
+    }
+    emit(")");
+  }
+
+  // A function argument: the parser insists on INT-compatible types,
+  // so only constants and parameters are used.
+  void genIntArg()
+  {
+    vector<string> params = visible(&SCOPE::params);
+    if (!params.empty() && chance(50))
+      emit(params[pick(params.size())]);
+    else if (chance(30))
+    {
+      emit(intConst(0, 99));
+      emit(chance(50) ? "+" : "*");
+      emit(intConst(0, 9));
+    }
+    else
+      emit(intConst(-99, 99));
+  }
+
+  void genFactor(const int depth)
+  {
+    vector<string> vars = visible(&SCOPE::numVars);
+    vector<string> params = visible(&SCOPE::params);
+    vars.insert(vars.end(), params.begin(), params.end());
+    vector<LIST_VAR> lists = visible(&SCOPE::lists);
+    bool haveCalls = !visible(&SCOPE::functions).empty();
+
+    if (haveCalls && chance(callPercent))
+    {
+      // a call is an EXPR, not a FACTOR, so it needs ( )
+      emit("(");
+      genCall();
+      emit(")");
+      return;
+    }
+    switch (pick(depth < maxDepth ? 7 : 4))
+    {
+      case 0:
+        emit(intConst(0, 999));
+        break;
+      case 1:
+        emit(floatConst());
+        break;
+      case 2:
+      case 3:
+        if (!vars.empty())
+          emit(vars[pick(vars.size())]);
+        else
+          emit(intConst(0, 999));
+        break;
+      case 4:
+        if (!lists.empty())
+        {
+          const LIST_VAR& l = lists[pick(lists.size())];
+          emit(l.name);
+          emit("[[");
+          emit(intConst(1, l.length));
+          emit("]]");
+        }
+        else
+          emit(intConst(0, 999));
+        break;
+      case 5:
+        emit("(");
+        genExpr(depth + 1);
+        emit(")");
+        break;
+      case 6:
+        if (pick(arithWeight + relWeight + logicWeight) >= arithWeight + relWeight)
+        {
+          emit("!");
+          genFactor(depth + 1);
+        }
+        else
+        {
+          // division and %% get a constant, positive divisor
+          emit("(");
+          genFactor(depth + 1);
+          emit(chance(70) ? "/" : "%%");
+          emit(chance(70) ? intConst(2, 9) : floatConst() + "1");
+          emit(")");
+        }
+        break;
+    }
+  }
+
+  void genTerm(const int depth)
+  {
+    genFactor(depth);
+    int numFactors = pick(3);
+    for (int i = 0; i < numFactors; i++)
+    {
+      int op = pick(arithWeight + logicWeight);
+      if (op < arithWeight)
+      {
+        if (chance(80))
+          emit("*");
+        else
+        {
+          // keep exponents small
+          emit("^");
+          emit(intConst(0, 3));
+          continue;
+        }
+      }
+      else
+        emit("&");
+      genFactor(depth);
+    }
+  }
+
+  void genSimple(const int depth)
+  {
+    genTerm(depth);
+    int numTerms = pick(4);
+    for (int i = 0; i < numTerms; i++)
+    {
+      int op = pick(arithWeight + logicWeight);
+      if (op < arithWeight)
+        emit(chance(50) ? "+" : "-");
+      else
+        emit("|");
+      genTerm(depth);
+    }
+  }
+
+  void genExpr(const int depth)
+  {
+    genSimple(depth);
+    if (pick(arithWeight + relWeight + logicWeight) < relWeight)
+    {
+      static const char* relOps[] = {"<", ">", "<=", ">=", "==", "!="};
+      emit(relOps[pick(6)]);
+      genSimple(depth);
+    }
+  }
+
+  void genListLiteral()
+  {
+    emit("list");
+    emit("(");
+    for (int i = 0; i < listLength; i++)
+    {
+      if (i > 0)
+        emit(",");
+      switch (pick(4))
+      {
+        case 0:
+          emit(floatConst());
+          break;
+        case 1:
+          emit(pick(2) ? "TRUE" : "FALSE");
+          break;
+        default:
+          emit(intConst(-999, 999));
+          break;
+      }
+    }
+    emit(")");
+  }
+
+  void genAssignment()
+  {
+    SCOPE& scope = scopes.back();
+    int kind = pick(10);
+    if ((kind == 0) && !scope.lists.empty())
+    {
+      // indexed assignment, only to a list of this scope
+      // the list takes the type of the new element afterwards, so
+      // it can't be used as a list again until it is reassigned
+      int i = pick(scope.lists.size());
+      emit(scope.lists[i].name);
+      emit("[[");
+      emit(intConst(1, scope.lists[i].length));
+      emit("]]");
+      emit("=");
+      genExpr(0);
+      addName(scope.numVars, scope.lists[i].name);
+      scope.lists.erase(scope.lists.begin() + i);
+    }
+    else if (kind == 1)
+    {
+      string name = "L" + to_string(pick(numIdents / 4 + 1));
+      emit(name);
+      emit("=");
+      genListLiteral();
+      if (!contains(scope.lists, name))
+      {
+        LIST_VAR l = {name, listLength};
+        scope.lists.push_back(l);
+      }
+      for (size_t i = 0; i < scope.numVars.size(); i++)
+        if (scope.numVars[i] == name)
+          scope.numVars.erase(scope.numVars.begin() + i);
+    }
+    else if (kind == 2)
+    {
+      string name = "s" + to_string(pick(numIdents / 4 + 1));
+      emit(name);
+      emit("=");
+      emit("\"str" + to_string(pick(1000)) + "\"");
+    }
+    else
+    {
+      string name = "x" + to_string(pick(numIdents));
+      emit(name);
+      emit("=");
+      genExpr(0);
+      addName(scope.numVars, name);
+    }
+  }
+
+  void genIf(const int nesting)
+  {
+    emit("if");
+    emit("(");
+    genExpr(0);
+    emit(")");
+    genBody(nesting);
+    if (chance(50))
+    {
+      emit("else");
+      genBody(nesting);
+    }
+  }
+
+  void genLoop(const int nesting)
+  {
+    vector<LIST_VAR> lists = visible(&SCOPE::lists);
+    if (!lists.empty() && chance(60))
+    {
+      string name = "i" + to_string(pick(numIdents));
+      emit("for");
+      emit("(");
+      emit(name);
+      emit("in");
+      if (chance(50))
+        emit(lists[pick(lists.size())].name);
+      else
+        genListLiteral();
+      emit(")");
+      addName(scopes.back().numVars, name);
+    }
+    else
+    {
+      emit("while");
+      emit("(");
+      genExpr(0);
+      emit(")");
+    }
+    genBody(nesting);
+  }
+
+  // print and cat show a value, which the interpreter only carries
+  // reliably through constants, list elements and one arithmetic
+  // operator, so their argument is kept that simple
+  void genOutput()
+  {
+    vector<LIST_VAR> lists = visible(&SCOPE::lists);
+    emit(chance(70) ? "print" : "cat");
+    emit("(");
+    switch (pick(5))
+    {
+      case 0:
+        emit("\"str" + to_string(pick(1000)) + "\"");
+        break;
+      case 1:
+        genListLiteral();
+        break;
+      case 2:
+        if (!lists.empty())
+        {
+          const LIST_VAR& l = lists[pick(lists.size())];
+          emit(l.name);
+          emit("[[");
+          emit(intConst(1, l.length));
+          emit("]]");
+          break;
+        }
+        // fall through
+      default:
+      {
+        static const char* ops[] = {"+", "-", "*"};
+        emit(chance(50) ? intConst(0, 999) : floatConst());
+        emit(ops[pick(3)]);
+        emit(intConst(0, 999));
+        break;
+      }
+    }
+    emit(")");
+  }
+
+  void genFunctionDef(const int nesting)
+  {
+    string name = "f" + to_string(pick(numIdents / 4 + 1));
+    int numParams = pick(4);
+    emit(name);
+    emit("=");
+    emit("function");
+    emit("(");
+    SCOPE scope;
+    for (int i = 0; i < numParams; i++)
+    {
+      if (i > 0)
+        emit(",");
+      scope.params.push_back("p" + to_string(i));
+      emit(scope.params.back());
+    }
+    emit(")");
+    scopes.push_back(scope);
+
+    // the body's last expression is its return value, so make it
+    // a plain arithmetic one
+    emit("{");
+    indent++;
+    int numStatements = 1 + pick(4);
+    for (int i = 0; i < numStatements; i++)
+    {
+      newline();
+      genStatement(nesting + 1);
+      emit(";");
+    }
+    newline();
+    genExpr(0);
+    indent--;
+    newline();
+    emit("}");
+    scopes.pop_back();
+
+    // a redefinition replaces the function
+    vector<FUNCTION_VAR>& functions = scopes.back().functions;
+    size_t i = 0;
+    while ((i < functions.size()) && (functions[i].name != name))
+      i++;
+    if (i == functions.size())
+      functions.push_back(FUNCTION_VAR());
+    functions[i].name = name;
+    functions[i].numParams = numParams;
+  }
+
+  // A statement in a body at the given nesting: now and then an if
+  // or loop that nests further, until the nesting reaches maxNesting,
+  // and otherwise a simple one. (Not a function definition: its
+  // value is a FUNCTION, which an if or loop body cannot have.)
+  void genBodyStatement(const int nesting)
+  {
+    if ((nesting < maxNesting) && chance(25))
+    {
+      if (chance(50))
+        genLoop(nesting);
+      else
+        genIf(nesting);
+    }
+    else
+      genSimpleStatement();
+  }
+
+  // The body of an if or loop at nesting - 1: a statement or a small
+  // block.
+  void genBody(const int nesting)
+  {
+    if (chance(50))
+    {
+      genBodyStatement(nesting + 1);
+      return;
+    }
+    emit("{");
+    indent++;
+    int numStatements = 1 + pick(3);
+    for (int i = 0; i < numStatements; i++)
+    {
+      newline();
+      genBodyStatement(nesting + 1);
+      if (i < numStatements - 1)
+        emit(";");
+    }
+    indent--;
+    newline();
+    emit("}");
+  }
+
+  // A statement that does not nest further.
+  void genSimpleStatement()
+  {
+    int kind = pick(10);
+    if (kind < 5)
+      genAssignment();
+    else if (kind < 8)
+      genExpr(0);
+    else
+      genOutput();
+  }
+
+  void genStatement(const int nesting)
+  {
+    if (chance(loopPercent))
+    {
+      genLoop(nesting);
+      return;
+    }
+    int kind = pick(20);
+    if ((kind == 0) && (nesting < maxNesting))
+      genFunctionDef(nesting);
+    else if (kind < 4)
+      genIf(nesting);
+    else if (kind < 6)
+      genOutput();
+    else if (kind < 9)
+      genExpr(0);
+    else
+      genAssignment();
+  }
+
+  // Generate statements until the token target is reached, grouping
+  // them into blocks of at most blockSize at each level.
+  void genBlock(const long long tokenBudget, const int level)
+  {
+    emit("{");
+    indent++;
+    long long start = numTokens;
+    int numStatements = 0;
+    while ((numTokens - start < tokenBudget) || (numStatements == 0))
+    {
+      if (numStatements > 0)
+        emit(";");
+      newline();
+      if ((blockSize > 0) && (level > 0))
+      {
+        // each nested block gets 1/blockSize of this one's budget
+        long long budget = tokenBudget / blockSize;
+        genBlock(budget > 0 ? budget : 1, level - 1);
+      }
+      else
+        genStatement(0);
+      numStatements++;
+    }
+    if (indent == 1)
+    {
+      // the program's value is printed at the end, so finish the
+      // outermost block with a plain one
+      emit(";");
+      newline();
+      emit(intConst(0, 999));
+    }
+    indent--;
+    newline();
+    emit("}");
+  }
+
+public:
+  //Constructor
+  GENERATOR( ) : targetTokens(1000), maxDepth(3), arithWeight(6), relWeight(2),
+    logicWeight(2), numIdents(8), maxNesting(2), listLength(8), loopPercent(10),
+    callPercent(10), blockSize(0), rng(1), numTokens(0), indent(0) { }
+
+  // Set options from the command line.
+  // If successful, return true; otherwise, return false.
+  bool parseArgs(int argc, char** argv)
+  {
+    for (int i = 1; i < argc; i++)
+    {
+      if (i + 1 >= argc)
+        return(false);
+      string opt = argv[i];
+      const char* val = argv[++i];
+      if (opt == "--tokens") targetTokens = atoll(val);
+      else if (opt == "--depth") maxDepth = atoi(val);
+      else if (opt == "--ops")
+      {
+        if (sscanf(val, "%d,%d,%d", &arithWeight, &relWeight, &logicWeight) != 3)
+          return(false);
+      }
+      else if (opt == "--idents") numIdents = atoi(val);
+      else if (opt == "--nesting") maxNesting = atoi(val);
+      else if (opt == "--list-len") listLength = atoi(val);
+      else if (opt == "--loops") loopPercent = atoi(val);
+      else if (opt == "--calls") callPercent = atoi(val);
+      else if (opt == "--block") blockSize = atoi(val);
+      else if (opt == "--seed") rng.seed(atoi(val));
+      else return(false);
+    }
+    return((numIdents > 0) && (listLength > 0) && (arithWeight > 0)
+           && (relWeight >= 0) && (logicWeight >= 0) && (blockSize >= 0));
+  }
+
+  void generate(FILE* file)
+  {
+    scopes.assign(1, SCOPE());
+    // depth of nested blocks needed to keep each at blockSize
+    int levels = 0;
+    for (long long n = targetTokens / 10; (blockSize > 1) && (n > blockSize); n /= blockSize)
+      levels++;
+    genBlock(targetTokens, levels);
+    out += '\n';
+    fwrite(out.data(), 1, out.size(), file);
+    fprintf(stderr, "%lld tokens\n", numTokens);
+  }
+
+};
+
+int main(int argc, char** argv)
+{
+  GENERATOR generator;
+  if (!generator.parseArgs(argc, argv))
+  {
+    fprintf(stderr, "usage: %s [--tokens N] [--depth N] [--ops A,R,L] [--idents N]\n"
+                    "       [--nesting N] [--list-len N] [--loops P] [--calls P]\n"
+                    "       [--block N] [--seed N]\n", argv[0]);
+    return 1;
+  }
+  generator.generate(stdout);
+  return 0;
+}
@@ -0,0 +1,326 @@
+/*
+    minir_server.cpp
+
+    Script server. Keeps a pool of warm worker processes listening on
+    a UNIX domain socket, so that running a script costs a connect()
+    rather than a fork/exec and a cold start of ./parser.
+
+    flex hol.l
+    bison hol.y
+    g++ -O2 -pthread minir_server.cpp -o minir_server -lrt
+    ./minir_server [-j workers] [-t seconds] [-r requests] socket
+    ./minir_server -c socket file...
+
+    The first form serves. Each worker accepts one connection at a
+    time, reads the script up to the client's end of file, runs it in
+    an INTERPRETER of its own, and streams the output back as it is
+    flushed, followed by the exit status ./parser would have had.
+    The workers are processes forked from the server, so a script
+    that crashes or runs past the time limit (default 10 s) takes
+    only its worker down; the server forks a new one. The time limit
+    counts from the connection, so it also bounds a client that is
+    slow to send its script, and a script over MAX_SCRIPT_SIZE is
+    refused. Workers default to one per CPU, and each exits after
+    serving a number of requests (default 1000) so that what scripts
+    leak does not build up; the server forks its replacement too.
+    read() in a script sees end of input.
+
+    The second form is the client: it sends each file in turn,
+    copies its output to stdout, and exits with the status of the
+    last file that failed (or 0), as a loop over ./parser would.
+
+    On the socket every reply is a series of frames, each a tag byte
+    and a 4-byte length in host order, then that many bytes:
+      'O'  a piece of output
+      'S'  the exit status, as text
+*/
+
+#define MINIR_NO_MAIN
+#include "hol.tab.c"
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <set>
+#include <string>
+using namespace std;
+
+#define FRAME_OUTPUT  'O'
+#define FRAME_STATUS  'S'
+
+#define MAX_SCRIPT_SIZE  (16 << 20)   // bytes
+
+// Write all of length bytes of data to fd.
+// If successful, return true; otherwise, return false.
+bool writeAll(const int fd, const char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t n = write(fd, data, length);
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        if (n <= 0)
+            return(false);
+        data += n;
+        length -= n;
+    }
+    return(true);
+}
+
+// Read exactly length bytes from fd into data.
+// If successful, return true; otherwise, return false.
+bool readAll(const int fd, char* data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t n = read(fd, data, length);
+        if ((n < 0) && (errno == EINTR))
+            continue;
+        if (n <= 0)
+            return(false);
+        data += n;
+        length -= n;
+    }
+    return(true);
+}
+
+// If successful, return true; otherwise, return false.
+bool writeFrame(const int fd, const char tag, const char* data, const size_t length)
+{
+    char header[1 + sizeof(uint32_t)];
+    uint32_t size = length;
+    header[0] = tag;
+    memcpy(header + 1, &size, sizeof(size));
+    return(writeAll(fd, header, sizeof(header)) && writeAll(fd, data, length));
+}
+
+// If successful, return true; otherwise, return false.
+bool readFrame(const int fd, char& tag, string& data)
+{
+    char header[1 + sizeof(uint32_t)];
+    uint32_t size;
+    if (!readAll(fd, header, sizeof(header)))
+        return(false);
+    tag = header[0];
+    memcpy(&size, header + 1, sizeof(size));
+    data.resize(size);
+    return((size == 0) || readAll(fd, &data[0], size));
+}
+
+// Return a UNIX domain socket address for path.
+// If path fits, return true; otherwise, return false.
+bool socketAddress(const string path, struct sockaddr_un& address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+        return(false);
+    strcpy(address.sun_path, path.c_str());
+    return(true);
+}
+
+// Run the script the client on connection sends, and send back its
+// output and status.
+void serveRequest(const int connection, const int seconds)
+{
+    alarm(seconds);
+    string source;
+    char buffer[65536];
+    ssize_t n;
+    while (((n = read(connection, buffer, sizeof(buffer))) > 0)
+           || ((n < 0) && (errno == EINTR)))
+    {
+        if (n > 0)
+            source.append(buffer, n);
+        if (source.size() > MAX_SCRIPT_SIZE)
+        {
+            alarm(0);
+            const char message[] = "Script too large\n";
+            writeFrame(connection, FRAME_OUTPUT, message, sizeof(message) - 1);
+            writeFrame(connection, FRAME_STATUS, "1", 1);
+            return;
+        }
+    }
+
+    INTERPRETER interpreter;
+    interpreter.setOutputHandler([connection](const char* text, size_t length)
+                                 { writeFrame(connection, FRAME_OUTPUT, text, length); });
+    interpreter.setInputHandler([](string& line) { return(false); });
+    string status = to_string(interpreter.evaluate(source));
+    alarm(0);
+    writeFrame(connection, FRAME_STATUS, status.data(), status.size());
+}
+
+// A worker: serve one connection at a time, maxRequests of them,
+// and exit. Never returns.
+void work(const int listener, const int seconds, const int maxRequests)
+{
+    signal(SIGPIPE, SIG_IGN);
+    for (int served = 0; served < maxRequests; served++)
+    {
+        int connection = accept(listener, NULL, NULL);
+        if (connection < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            _exit(2);
+        }
+        serveRequest(connection, seconds);
+        close(connection);
+    }
+    _exit(0);
+}
+
+// Fork a worker.
+// If successful, return its pid; otherwise, return -1.
+pid_t startWorker(const int listener, const int seconds, const int maxRequests)
+{
+    pid_t pid = fork();
+    if (pid == 0)
+        work(listener, seconds, maxRequests);
+    return(pid);
+}
+
+int serve(const string path, const int numWorkers, const int seconds, const int maxRequests)
+{
+    struct sockaddr_un address;
+    if (!socketAddress(path, address))
+    {
+        fprintf(stderr, "socket path too long: %s\n", path.c_str());
+        return 2;
+    }
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(path.c_str());
+    if ((listener < 0)
+    || (bind(listener, (struct sockaddr*) &address, sizeof(address)) != 0)
+    || (listen(listener, SOMAXCONN) != 0))
+    {
+        perror(path.c_str());
+        return 2;
+    }
+
+    set<pid_t> workers;
+    for (int i = 0; i < numWorkers; i++)
+    {
+        pid_t pid = startWorker(listener, seconds, maxRequests);
+        if (pid < 0)
+        {
+            perror("fork");
+            return 2;
+        }
+        workers.insert(pid);
+    }
+    fprintf(stderr, "serving %s with %d workers\n", path.c_str(), numWorkers);
+
+    // replace any worker that dies or has served its requests; the
+    // client of one that dies sees the connection close without a
+    // status
+    for (;;)
+    {
+        int status;
+        pid_t pid = wait(&status);
+        if (pid < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            perror("wait");
+            return 2;
+        }
+        if (workers.erase(pid) == 0)
+            continue;
+        if (WIFSIGNALED(status))
+            fprintf(stderr, "worker %d: %s\n", (int) pid,
+                    (WTERMSIG(status) == SIGALRM) ? "timed out" : strsignal(WTERMSIG(status)));
+        pid = startWorker(listener, seconds, maxRequests);
+        if (pid > 0)
+            workers.insert(pid);
+    }
+}
+
+// Send fileName to the server at path and copy its output to stdout.
+// Return the script's exit status, or 2 if it did not finish.
+int submit(const string path, const string fileName)
+{
+    FILE* file = fopen(fileName.c_str(), "r");
+    if (file == NULL)
+    {
+        perror(fileName.c_str());
+        return 2;
+    }
+    struct sockaddr_un address;
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (!socketAddress(path, address) || (connection < 0)
+    || (connect(connection, (struct sockaddr*) &address, sizeof(address)) != 0))
+    {
+        perror(path.c_str());
+        fclose(file);
+        return 2;
+    }
+
+    char buffer[65536];
+    size_t n;
+    bool sent = true;
+    while (sent && ((n = fread(buffer, 1, sizeof(buffer), file)) > 0))
+        sent = writeAll(connection, buffer, n);
+    fclose(file);
+    shutdown(connection, SHUT_WR);
+
+    int status = 2;
+    char tag;
+    string data;
+    while (readFrame(connection, tag, data))
+    {
+        if (tag == FRAME_OUTPUT)
+            fwrite(data.data(), 1, data.size(), stdout);
+        else if (tag == FRAME_STATUS)
+            status = atoi(data.c_str());
+    }
+    close(connection);
+    fflush(stdout);
+    if (status == 2)
+        fprintf(stderr, "%s: the server did not finish it\n", fileName.c_str());
+    return(status);
+}
+
+int main(int argc, char** argv)
+{
+    int numWorkers = sysconf(_SC_NPROCESSORS_ONLN);
+    int seconds = 10;
+    int maxRequests = 1000;
+    int arg = 1;
+    if ((argc >= 4) && (strcmp(argv[1], "-c") == 0))
+    {
+        // a server that refuses a script stops reading it; its reply
+        // is still there to read
+        signal(SIGPIPE, SIG_IGN);
+        int status = 0;
+        for (arg = 3; arg < argc; arg++)
+        {
+            int fileStatus = submit(argv[2], argv[arg]);
+            if (fileStatus != 0)
+                status = fileStatus;
+        }
+        return(status);
+    }
+
+    for (; (arg + 1 < argc) && (argv[arg][0] == '-'); arg += 2)
+    {
+        if (strcmp(argv[arg], "-j") == 0)
+            numWorkers = atoi(argv[arg + 1]);
+        else if (strcmp(argv[arg], "-t") == 0)
+            seconds = atoi(argv[arg + 1]);
+        else if (strcmp(argv[arg], "-r") == 0)
+            maxRequests = atoi(argv[arg + 1]);
+        else
+            break;
+    }
+    if ((argc - arg != 1) || (numWorkers < 1) || (seconds < 1) || (maxRequests < 1))
+    {
+        fprintf(stderr, "usage: %s [-j workers] [-t seconds] [-r requests] socket\n"
+                        "       %s -c socket file...\n", argv[0], argv[0]);
+        return 2;
+    }
+    return(serve(argv[arg], numWorkers, seconds, maxRequests));
+}
@@ -0,0 +1,292 @@
+/*
+    perf.cpp
+
+    Performance regression harness. Runs the interpreter on each
+    input several times and records wall time, user and system CPU
+    time and peak RSS, then compares them against a baseline
+    written by an earlier run.
+
+    g++ -O2 perf.cpp -o perf
+    ./perf [options] parser input...
+
+    Options (defaults in brackets):
+      --runs N          runs per input [5]
+      --threshold P     flag a measurement more than P% above its
+                        baseline [10]
+      --baseline FILE   compare against FILE [perf_baseline.json]
+      --output FILE     also write this run's results to FILE
+      --save            write the results to the baseline file
+                        instead of comparing
+
+    Times are the median over the runs and RSS the maximum. CPU times
+    and RSS come from wait4(), so they cover only the child. A
+    difference must also clear a small absolute floor before it
+    counts, since runs of a few milliseconds are mostly noise.
+    Exits with 1 if anything regressed.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <algorithm>
+using namespace std;
+
+#define NUM_MEASURES  4
+const char* MEASURE_NAMES[NUM_MEASURES] = {"wall_ms", "user_ms", "sys_ms", "maxrss_kb"};
+// differences below these never count as regressions; CPU times
+// are charged in whole scheduler ticks, so their floor is higher
+const double MIN_DELTAS[NUM_MEASURES] = {5.0, 10.0, 10.0, 512.0};
+
+typedef struct {
+    double values[NUM_MEASURES];    // in MEASURE_NAMES order
+} PERF_RESULT;
+
+typedef struct {
+    int numRuns;
+    double threshold;
+    string baselineFile;
+    string outputFile;
+    bool save;
+} PERF_OPTIONS;
+
+double toMillis(const struct timeval& tv)
+{
+    return(tv.tv_sec * 1e3 + tv.tv_usec / 1e3);
+}
+
+// Run "parser input" once with its output discarded. Fill in result
+// with its wall time, CPU times and peak RSS.
+// If the child ran and exited, return true; otherwise, return false.
+bool runOnce(const char* parser, const char* input, PERF_RESULT& result)
+{
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid < 0)
+        return(false);
+    if (pid == 0)
+    {
+        int devNull = open("/dev/null", O_RDWR);
+        dup2(devNull, STDIN_FILENO);
+        dup2(devNull, STDOUT_FILENO);
+        dup2(devNull, STDERR_FILENO);
+        execl(parser, parser, input, (char*) NULL);
+        _exit(127);
+    }
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) != pid)
+        return(false);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    result.values[0] = (end.tv_sec - start.tv_sec) * 1e3 + (end.tv_nsec - start.tv_nsec) / 1e6;
+    result.values[1] = toMillis(usage.ru_utime);
+    result.values[2] = toMillis(usage.ru_stime);
+    result.values[3] = usage.ru_maxrss;
+    // a semantic error exits with 1, which is still a valid run
+    return(WIFEXITED(status) && (WEXITSTATUS(status) != 127));
+}
+
+// Run input numRuns times, and return the median times and the
+// largest RSS.
+// If every run succeeded, return true; otherwise, return false.
+bool measure(const char* parser, const char* input, const int numRuns,
+             PERF_RESULT& result)
+{
+    vector<double> samples[NUM_MEASURES];
+    for (int i = 0; i < numRuns; i++)
+    {
+        PERF_RESULT run;
+        if (!runOnce(parser, input, run))
+            return(false);
+        for (int m = 0; m < NUM_MEASURES; m++)
+            samples[m].push_back(run.values[m]);
+    }
+    for (int m = 0; m < NUM_MEASURES - 1; m++)
+    {
+        sort(samples[m].begin(), samples[m].end());
+        result.values[m] = samples[m][numRuns / 2];
+    }
+    result.values[NUM_MEASURES - 1] = *max_element(samples[NUM_MEASURES - 1].begin(),
+                                                    samples[NUM_MEASURES - 1].end());
+    return(true);
+}
+
+// Write results as JSON, one input per line.
+// If successful, return true; otherwise, return false.
+bool writeResults(const string fileName, const int numRuns,
+                  const map<string, PERF_RESULT>& results)
+{
+    FILE* out = fopen(fileName.c_str(), "w");
+    if (out == NULL)
+        return(false);
+    fprintf(out, "{\n  \"runs\": %d,\n  \"inputs\": {\n", numRuns);
+    for (map<string, PERF_RESULT>::const_iterator itr = results.begin();
+         itr != results.end(); ++itr)
+    {
+        fprintf(out, "    \"");
+        for (size_t i = 0; i < itr->first.size(); i++)
+        {
+            if ((itr->first[i] == '"') || (itr->first[i] == '\\'))
+                fputc('\\', out);
+            fputc(itr->first[i], out);
+        }
+        fprintf(out, "\": {");
+        for (int m = 0; m < NUM_MEASURES; m++)
+            fprintf(out, "%s\"%s\": %.3f", (m > 0) ? ", " : "", MEASURE_NAMES[m],
+                    itr->second.values[m]);
+        fprintf(out, "}%s\n", (next(itr) != results.end()) ? "," : "");
+    }
+    fprintf(out, "  }\n}\n");
+    return(fclose(out) == 0);
+}
+
+// Read a file written by writeResults.
+// If successful, return true; otherwise, return false.
+bool readResults(const string fileName, map<string, PERF_RESULT>& results)
+{
+    FILE* in = fopen(fileName.c_str(), "r");
+    if (in == NULL)
+        return(false);
+    char line[4096];
+    while (fgets(line, sizeof(line), in) != NULL)
+    {
+        // input lines are the ones with a measurement on them
+        char* p = strchr(line, '"');
+        if ((p == NULL) || (strstr(line, MEASURE_NAMES[0]) == NULL))
+            continue;
+        string name;
+        for (p++; (*p != '\0') && (*p != '"'); p++)
+        {
+            if ((*p == '\\') && (p[1] != '\0'))
+                p++;
+            name += *p;
+        }
+
+        PERF_RESULT result;
+        bool complete = true;
+        for (int m = 0; m < NUM_MEASURES; m++)
+        {
+            string key = string("\"") + MEASURE_NAMES[m] + "\":";
+            char* value = strstr(p, key.c_str());
+            complete = complete && (value != NULL)
+                       && (sscanf(value + key.size(), "%lf", &result.values[m]) == 1);
+        }
+        if (complete)
+            results[name] = result;
+    }
+    fclose(in);
+    return(true);
+}
+
+// If successful, return true; otherwise, return false.
+bool parseArgs(int argc, char** argv, PERF_OPTIONS& options, int& firstArg)
+{
+    options.numRuns = 5;
+    options.threshold = 10;
+    options.baselineFile = "perf_baseline.json";
+    options.save = false;
+    int i = 1;
+    for (; (i < argc) && (strncmp(argv[i], "--", 2) == 0); i++)
+    {
+        string opt = argv[i];
+        if (opt == "--save")
+        {
+            options.save = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            return(false);
+        const char* val = argv[++i];
+        if (opt == "--runs") options.numRuns = atoi(val);
+        else if (opt == "--threshold") options.threshold = atof(val);
+        else if (opt == "--baseline") options.baselineFile = val;
+        else if (opt == "--output") options.outputFile = val;
+        else return(false);
+    }
+    firstArg = i;
+    return((options.numRuns > 0) && (options.threshold >= 0) && (argc - i >= 2));
+}
+
+int main(int argc, char** argv)
+{
+    PERF_OPTIONS options;
+    int firstArg;
+    if (!parseArgs(argc, argv, options, firstArg))
+    {
+        fprintf(stderr, "usage: %s [--runs N] [--threshold P] [--baseline FILE]\n"
+                        "       [--output FILE] [--save] parser input...\n", argv[0]);
+        return 2;
+    }
+    const char* parser = argv[firstArg];
+
+    map<string, PERF_RESULT> baseline;
+    if (!options.save && !readResults(options.baselineFile, baseline))
+        fprintf(stderr, "no baseline in %s; run with --save to record one\n",
+                options.baselineFile.c_str());
+
+    printf("%-36s %10s %10s %10s %10s\n", "input", "wall ms", "user ms", "sys ms", "maxrss KB");
+    map<string, PERF_RESULT> results;
+    int numRegressions = 0;
+    for (int i = firstArg + 1; i < argc; i++)
+    {
+        const char* input = argv[i];
+        const char* name = strrchr(input, '/');
+        name = (name != NULL) ? name + 1 : input;
+
+        PERF_RESULT result;
+        if (!measure(parser, input, options.numRuns, result))
+        {
+            fprintf(stderr, "%s: could not run %s\n", input, parser);
+            return 2;
+        }
+        results[name] = result;
+
+        printf("%-36s", name);
+        for (int m = 0; m < NUM_MEASURES; m++)
+            printf(" %10.2f", result.values[m]);
+
+        map<string, PERF_RESULT>::const_iterator base = baseline.find(name);
+        if (base != baseline.end())
+        {
+            for (int m = 0; m < NUM_MEASURES; m++)
+            {
+                double was = base->second.values[m];
+                double now = result.values[m];
+                if ((now - was > MIN_DELTAS[m])
+                && (now > was * (1 + options.threshold / 100)))
+                {
+                    printf("  REGRESSION %s %.2f -> %.2f (+%.0f%%)", MEASURE_NAMES[m],
+                           was, now, (was > 0) ? (now / was - 1) * 100 : 100.0);
+                    numRegressions++;
+                }
+            }
+        }
+        printf("\n");
+    }
+
+    if (options.save && !writeResults(options.baselineFile, options.numRuns, results))
+    {
+        fprintf(stderr, "could not write %s\n", options.baselineFile.c_str());
+        return 2;
+    }
+    if (!options.outputFile.empty() && !writeResults(options.outputFile, options.numRuns, results))
+    {
+        fprintf(stderr, "could not write %s\n", options.outputFile.c_str());
+        return 2;
+    }
+    if (!options.save && !baseline.empty())
+        printf("\n%d regression%s beyond %.0f%%\n", numRegressions,
+               (numRegressions == 1) ? "" : "s", options.threshold);
+    return (numRegressions > 0) ? 1 : 0;
+}
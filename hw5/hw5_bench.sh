@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# To run:
+#	bash hw5_bench.sh [cpu]
+
+# Builds the microbenchmarks in hol/bench.cpp against the interpreter
+# and runs them pinned to the given CPU (default 0). Each line reports
+# the median and 99th percentile ns per operation, and a throughput
+# where one makes sense.
+
+cd "$(dirname "$0")/hol"
+
+	flex hol.l
+	bison hol.y
+	g++-8 -std=c++11 -O2 -pthread bench.cpp -o bench -lrt
+
+./bench $1
@@ -0,0 +1,21 @@
+#!/bin/bash
+
+# To run:
+#	bash hw5_conform.sh [-j jobs] [-t seconds]
+
+# Builds hol/conform.cpp against the interpreter and runs every file
+# in sample_input through it in parallel, comparing each output with
+# expected_output the way hw5_reports.sh does. Outputs go to
+# actual_output and side-by-side reports to reports, as before; the
+# script exits with 1 if any input fails.
+
+cd "$(dirname "$0")"
+mkdir -p actual_output reports
+
+cd hol
+
+	flex hol.l
+	bison hol.y
+	g++-8 -std=c++11 -O2 -pthread conform.cpp -o conform -lrt
+
+./conform "$@" ../sample_input ../expected_output ../actual_output ../reports
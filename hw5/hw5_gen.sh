@@ -0,0 +1,14 @@
+#!/bin/bash
+
+# To run:
+#	bash hw5_gen.sh [minir_gen options] > program.txt
+
+# Builds hol/minir_gen.cpp and writes a generated MiniR program to
+# stdout; see the top of minir_gen.cpp for the options. For example,
+#	bash hw5_gen.sh --tokens 1000000 --block 100 --seed 3 > big.txt
+
+cd "$(dirname "$0")/hol"
+
+	g++-8 -std=c++11 -O2 minir_gen.cpp -o minir_gen
+
+./minir_gen "$@"
@@ -0,0 +1,15 @@
+#!/bin/bash
+
+# To run:
+#	bash hw5_lib.sh
+
+# Builds the interpreter as a library, hol/libminir.a, for programs
+# that embed it through hol/minir.h instead of running ./parser once
+# per script. Link with: -Ihol hol/libminir.a -pthread -lrt
+
+cd "$(dirname "$0")/hol"
+
+	flex hol.l
+	bison hol.y
+	g++-8 -std=c++11 -O2 -pthread -fPIC -DMINIR_NO_MAIN -c hol.tab.c -o minir.o
+	ar rcs libminir.a minir.o
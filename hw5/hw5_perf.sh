@@ -0,0 +1,29 @@
+#!/bin/bash
+
+# To run:
+#	bash hw5_perf.sh --save [--runs N]      record perf_baseline.json
+#	bash hw5_perf.sh [--runs N] [--threshold P]
+
+# Builds the parser and hol/perf.cpp, then runs the parser on every
+# file in sample_input (or the files given with --inputs DIR) N times
+# (default 5). Wall time, user/sys CPU time and peak RSS are compared
+# against perf_baseline.json, and anything more than P% (default 10)
+# slower or larger is flagged; the script then exits with 1. This
+# run's numbers are also written to reports/perf.json.
+
+cd "$(dirname "$0")"
+inputDir=sample_input
+if [ "$1" == "--inputs" ]; then
+    inputDir=$2
+    shift 2
+fi
+inputs=`ls -d $PWD/$inputDir/* --ignore-backups`
+
+cd hol
+
+	flex hol.l
+	bison hol.y
+	g++-8 -std=c++11 -O2 -pthread hol.tab.c -o parser -lrt
+	g++-8 -std=c++11 -O2 perf.cpp -o perf
+
+./perf --baseline ../perf_baseline.json --output ../reports/perf.json "$@" ./parser $inputs
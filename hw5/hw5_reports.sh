@@ -8,7 +8,7 @@
 
 	flex hol.l
 	bison hol.y
-	g++-8 -std=c++11 hol.tab.c -o parser
+	g++-8 -std=c++11 -pthread hol.tab.c -o parser -lrt
 
 # This script also assumes you have the provided sample input files from
 # Canvas in a directory called "sample_input", and the expected output files
@@ -0,0 +1,17 @@
+#!/bin/bash
+
+# To run:
+#	bash hw5_server.sh [-j workers] [-t seconds] socket
+#	hol/minir_server -c socket file...
+
+# Builds hol/minir_server.cpp against the interpreter and starts it
+# serving scripts on the given UNIX domain socket; the second form
+# runs scripts through it. See hol/minir_server.cpp.
+
+cd "$(dirname "$0")/hol"
+
+	flex hol.l
+	bison hol.y
+	g++-8 -std=c++11 -O2 -pthread minir_server.cpp -o minir_server -lrt
+
+exec ./minir_server "$@"